@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -66,6 +67,175 @@ typedef void*
 typedef void
 (*ptg_log_callback)(void* logger_data, PtgSeverity severity, const char* message);
 
+/**
+ * @brief Used to select how log records are passed to the logger function.
+ *
+ * @ingroup ptg_device
+ */
+enum ptg_log_mode
+{
+  /** Records are passed to the logger function right away, on the thread that logged them. */
+  PTG_LOG_IMMEDIATE,
+  /**
+   * Records are queued, and passed to the logger function when @ref PtgDevice_FlushLog is called, on the thread that
+   * calls it (and when the device is deleted).
+   */
+  PTG_LOG_DEFERRED,
+  /** Records are queued, and passed to the logger function by a thread of the device's own. */
+  PTG_LOG_BACKGROUND
+};
+
+/**
+ * @brief A type definition for log modes.
+ *
+ * @ingroup ptg_device
+ */
+typedef enum ptg_log_mode PtgLogMode;
+
+/**
+ * @brief The type of the function that processes a range of indices of a parallel loop.
+ *
+ * @param task_data The pointer that was passed along with the function when the loop was submitted.
+ *
+ * @param begin The first index of the range.
+ *
+ * @param end One past the last index of the range.
+ *
+ * @ingroup ptg_device
+ */
+typedef void
+(*ptg_task_func)(void* task_data, uint32_t begin, uint32_t end);
+
+/**
+ * @brief Lets the device run its parallel work on the job system of the calling environment, instead of on threads
+ *        of its own.
+ *
+ * @ingroup ptg_device
+ */
+struct ptg_scheduler
+{
+  /** An optional pointer that is passed to both functions. */
+  void* scheduler_data;
+
+  /**
+   * Submits a parallel loop over the indices [0, count). The indices may be split into ranges of any size, and the
+   * ranges may run on any thread, but each index must be passed to the task function exactly once.
+   * Returns a handle that is later passed to the wait function, which may be null.
+   * Loops may be submitted from several threads at once, and from within the task function of another loop.
+   */
+  void* (*submit)(void* scheduler_data, uint32_t count, ptg_task_func func, void* task_data);
+
+  /**
+   * Waits until every index of a submitted loop has been processed. The calling thread may be one of the workers
+   * of the job system, so this should run other work while waiting instead of blocking the thread.
+   */
+  void (*wait)(void* scheduler_data, void* task);
+};
+
+/**
+ * @brief A type definition for schedulers.
+ *
+ * @ingroup ptg_device
+ */
+typedef struct ptg_scheduler PtgScheduler;
+
+/**
+ * @brief Lets the device allocate its memory from the calling environment, such as from an arena or a huge page
+ *        allocator, or through an allocator that reports to the telemetry of the calling environment.
+ *
+ * @details Texel storage, buffers and the path data of models are allocated through these functions. Small
+ *          bookkeeping structures and per-thread scratch memory still come from the global heap. The functions may be
+ *          called from any thread, including several at once, until the device and every object created with it have
+ *          been deleted.
+ *
+ * @ingroup ptg_device
+ */
+struct ptg_allocator
+{
+  /** An optional pointer that is passed to every function. */
+  void* allocator_data;
+
+  /**
+   * Allocates a number of bytes (never zero), aligned to a power of two no larger than 64.
+   * Returns null if the memory could not be allocated.
+   */
+  void* (*alloc)(void* allocator_data, size_t size, size_t alignment);
+
+  /**
+   * Resizes an allocation, keeping its contents up to the smaller of the two sizes, and returns the (possibly moved)
+   * memory. Returns null if the memory could not be allocated, in which case the original allocation must be left
+   * untouched. This may be null, in which case allocations are resized with alloc and free.
+   */
+  void* (*realloc)(void* allocator_data, void* ptr, size_t old_size, size_t new_size, size_t alignment);
+
+  /** Frees memory returned by alloc or realloc. The size is the number of bytes that were asked for. */
+  void (*free)(void* allocator_data, void* ptr, size_t size);
+};
+
+/**
+ * @brief A type definition for allocators.
+ *
+ * @ingroup ptg_device
+ */
+typedef struct ptg_allocator PtgAllocator;
+
+/**
+ * @brief Options for creating a device.
+ *        Initialize with @ref PtgDeviceOptions_Init before setting fields, so that new fields get default values.
+ *
+ * @ingroup ptg_device
+ */
+struct ptg_device_options
+{
+  /** Used for loading symbols from an OpenGL context. If null, everything is done in software. */
+  ptg_gl_symbol_loader gl_symbol_loader;
+
+  /** An optional pointer to pass to the logger callback function. */
+  void* logger_data;
+
+  /** An optional function pointer to pass log records to. */
+  ptg_log_callback logger_func;
+
+  /**
+   * The job system to run parallel work on. If the submit and wait functions are null, the device starts a pool of
+   * worker threads of its own.
+   */
+  PtgScheduler scheduler;
+
+  /**
+   * The largest number of bytes that the textures and buffers of the device may hold, or zero for no limit.
+   * See @ref PtgDevice_SetMemoryBudget.
+   */
+  uint64_t memory_budget;
+
+  /** The allocator to allocate memory with. If the alloc and free functions are null, the device uses its own. */
+  PtgAllocator allocator;
+
+  /**
+   * How log records are passed to the logger function. The queued modes keep threads that log (such as the workers
+   * running kernels) from waiting on a slow logger function. Queued records never wait for room: when the queue is
+   * full, records are dropped, and a warning saying how many follows the next records that are passed on.
+   * The default is @ref PTG_LOG_IMMEDIATE.
+   */
+  PtgLogMode log_mode;
+
+  /** For the queued log modes, the number of records that can be queued. If this is zero, a default is used. */
+  uint32_t log_queue_capacity;
+
+  /**
+   * The lowest severity of the records to log. Records below it are discarded before their message is formatted.
+   * The default is @ref PTG_INFO.
+   */
+  PtgSeverity log_level;
+};
+
+/**
+ * @brief A type definition for device options.
+ *
+ * @ingroup ptg_device
+ */
+typedef struct ptg_device_options PtgDeviceOptions;
+
 /**
 * @brief The type definition for a device object.
 *
@@ -76,6 +246,10 @@ typedef struct ptg_device PtgDevice;
 /**
  * @brief Creates a new device instance.
  *
+ * @details A device may be shared by several threads. Objects created with the device (such as outputs, renders and
+ *          chunk caches) can be used from different threads at the same time, as long as each object is only used by
+ *          one thread at a time. The logger function may then be called from any of those threads.
+ *
  * @param gl_symbol_loader Used for loading symbols from an OpenGL context.
  *                         This function may be null, in which case everything is done in software.
  *
@@ -90,6 +264,274 @@ typedef struct ptg_device PtgDevice;
 PtgDevice*
 PtgDevice_New(ptg_gl_symbol_loader gl_symbol_loader, void* logger_data, ptg_log_callback logger_func);
 
+/**
+ * @brief Assigns the default values to a set of device options.
+ *
+ * @param options The options to initialize.
+ *
+ * @ingroup ptg_device
+ */
+void
+PtgDeviceOptions_Init(PtgDeviceOptions* options);
+
+/**
+ * @brief Creates a new device instance, with control over how it runs its work.
+ *
+ * @param options The options to create the device with.
+ *
+ * @return A new device instance.
+ *
+ * @ingroup ptg_device
+ */
+PtgDevice*
+PtgDevice_NewWithOptions(const PtgDeviceOptions* options);
+
+/**
+ * @brief Counters for the dispatches of one kind of kernel. Times are wall times, in nanoseconds.
+ *
+ * @ingroup ptg_device
+ */
+struct ptg_kernel_stats
+{
+  /** The number of times the kernel was dispatched. */
+  uint64_t dispatch_count;
+
+  /** The total time spent in dispatches of the kernel. */
+  uint64_t total_time;
+
+  /** The time of the shortest dispatch, or zero if there were no dispatches. */
+  uint64_t min_time;
+
+  /** The time of the longest dispatch. */
+  uint64_t max_time;
+
+  /** The number of texels processed, leaving out regions that the kernel skipped. */
+  uint64_t texel_count;
+
+  /**
+   * The CPU cycles spent processing texels, summed over every thread.
+   * This and the following hardware counters are only collected once enabled with @ref PtgDevice_EnablePerfCounters.
+   * Counters that are not supported by the machine stay at zero.
+   */
+  uint64_t cycles;
+
+  /** The instructions retired while processing texels. */
+  uint64_t instructions;
+
+  /** The reads that missed the last level cache while processing texels. */
+  uint64_t llc_misses;
+
+  /** The reads that missed the data TLB while processing texels. */
+  uint64_t dtlb_misses;
+};
+
+/**
+ * @brief A type definition for kernel statistics.
+ *
+ * @ingroup ptg_device
+ */
+typedef struct ptg_kernel_stats PtgKernelStats;
+
+/**
+ * @brief Counters for the work done by a device since statistics were enabled or last reset.
+ *
+ * @ingroup ptg_device
+ */
+struct ptg_device_stats
+{
+  /** Counters for the kernel that applies raise operations while baking. */
+  PtgKernelStats raise_kernel;
+
+  /** Counters for the kernel that renders samples. */
+  PtgKernelStats render_kernel;
+
+  /** The number of textures allocated. */
+  uint64_t texture_count;
+
+  /** The number of bytes of texel data in the textures allocated, before any compression or paging. */
+  uint64_t texture_bytes;
+};
+
+/**
+ * @brief A type definition for device statistics.
+ *
+ * @ingroup ptg_device
+ */
+typedef struct ptg_device_stats PtgDeviceStats;
+
+/**
+ * @brief Enables or disables collecting statistics. Statistics are disabled by default, and cost next to nothing
+ *        while disabled. Disabling statistics keeps the counters collected so far.
+ *
+ * @param device The device to collect statistics for.
+ *
+ * @param enabled Whether to collect statistics.
+ *
+ * @ingroup ptg_device
+ */
+void
+PtgDevice_EnableStats(PtgDevice* device, bool enabled);
+
+/**
+ * @brief Reads the statistics collected by a device.
+ *
+ * @param device The device to read the statistics of.
+ *
+ * @param stats Assigned the statistics of the device.
+ *
+ * @ingroup ptg_device
+ */
+void
+PtgDevice_GetStats(PtgDevice* device, PtgDeviceStats* stats);
+
+/**
+ * @brief Sets the statistics of a device back to zero.
+ *
+ * @param device The device to reset the statistics of.
+ *
+ * @ingroup ptg_device
+ */
+void
+PtgDevice_ResetStats(PtgDevice* device);
+
+/**
+ * @brief Enables or disables counting hardware events (cycles, instructions, cache and TLB misses) per kernel.
+ *        The events are reported in the kernel statistics, and are counted while statistics are enabled.
+ *        Events are counted with perf_event_open, which is only available on Linux, and may be restricted by the
+ *        perf_event_paranoid setting of the system.
+ *
+ * @param device The device to count hardware events for.
+ *
+ * @param enabled Whether to count hardware events.
+ *
+ * @return True if the counters can be opened, false if they are unavailable. When unavailable, the hardware
+ *         counters in the statistics stay at zero.
+ *
+ * @ingroup ptg_device
+ */
+bool
+PtgDevice_EnablePerfCounters(PtgDevice* device, bool enabled);
+
+/**
+ * @brief Counters for the memory held by a device, or by the textures of an output or render.
+ *
+ * @details The live bytes count the memory actually held: textures that keep their texels compressed, sparse or
+ *          paged count only what they currently hold. For a device, this is every byte allocated through it (so
+ *          texels shared between copies count once), and the peak is exact. For an output or render, copies that
+ *          still share their texels count a share of them, and the peak is sampled when textures are created and
+ *          when the counters are read. Memory-mapped textures are left out, since their texels are file pages that
+ *          the system can reclaim.
+ *
+ * @ingroup ptg_device
+ */
+struct ptg_memory_stats
+{
+  /** The number of bytes currently held. */
+  uint64_t live_bytes;
+
+  /** The largest number of live bytes seen. */
+  uint64_t peak_bytes;
+
+  /**
+   * For a device, the number of blocks of memory allocated (including the tiles that textures allocate as they are
+   * written). For an output or render, the number of textures created.
+   */
+  uint64_t allocation_count;
+};
+
+/**
+ * @brief A type definition for memory statistics.
+ *
+ * @ingroup ptg_device
+ */
+typedef struct ptg_memory_stats PtgMemoryStats;
+
+/**
+ * @brief Reads the memory held by the textures and buffers of a device.
+ *        Unlike the other statistics, memory statistics are always collected.
+ *
+ * @param device The device to read the memory statistics of.
+ *
+ * @param stats Assigned the memory statistics of the device.
+ *
+ * @ingroup ptg_device
+ */
+void
+PtgDevice_GetMemoryStats(PtgDevice* device, PtgMemoryStats* stats);
+
+/**
+ * @brief Limits the memory that the textures and buffers of a device may hold.
+ *        Every allocation is checked, including the tiles that sparse, compressed, paged and copied textures
+ *        allocate as they are written. When an allocation would exceed the budget, the device first releases the
+ *        tiles that page caches keep in memory (writing modified tiles back to their files). If that does not make
+ *        enough room, an error is logged and the allocation fails, along with the operation that needed it. Tiles
+ *        that fail to allocate while baking are skipped.
+ *
+ * @param device The device to limit.
+ *
+ * @param budget The largest number of bytes to hold, or zero for no limit.
+ *
+ * @ingroup ptg_device
+ */
+void
+PtgDevice_SetMemoryBudget(PtgDevice* device, uint64_t budget);
+
+/**
+ * @brief Starts recording a timeline of the work done by a device, discarding any events recorded so far.
+ *        Bake operations, kernel dispatches, the tiles of each dispatch (on the thread that processed them), texture
+ *        allocations, render iterations and exports are recorded. Once the buffer is full, new events replace the
+ *        oldest ones. Tracing is disabled by default, and costs next to nothing while disabled.
+ *
+ *        This must not be called while the device is in use by other threads.
+ *
+ * @param device The device to trace.
+ *
+ * @param event_capacity The number of events to keep. If this is zero, tracing is disabled.
+ *
+ * @ingroup ptg_device
+ */
+void
+PtgDevice_EnableTrace(PtgDevice* device, uint32_t event_capacity);
+
+/**
+ * @brief Writes the events recorded by a device to a file, in the Chrome trace event format.
+ *        The file can be opened with chrome://tracing or with Perfetto.
+ *
+ * @param device The device to write the trace of.
+ *
+ * @param path The path of the file to write.
+ *
+ * @return True on success, false if the file could not be written.
+ *
+ * @ingroup ptg_device
+ */
+bool
+PtgDevice_WriteTrace(PtgDevice* device, const char* path);
+
+/**
+ * @brief Passes the log records queued by a device to the logger function, on the calling thread.
+ *        This does nothing unless the device was created with @ref PTG_LOG_DEFERRED or @ref PTG_LOG_BACKGROUND.
+ *
+ * @param device The device to flush the log of.
+ *
+ * @ingroup ptg_device
+ */
+void
+PtgDevice_FlushLog(PtgDevice* device);
+
+/**
+ * @brief Sets the lowest severity of the log records that a device passes to the logger function.
+ *        Records below it are discarded before their message is formatted.
+ *
+ * @param device The device to set the log level of.
+ *
+ * @param level The lowest severity to log.
+ *
+ * @ingroup ptg_device
+ */
+void
+PtgDevice_SetLogLevel(PtgDevice* device, PtgSeverity level);
+
 /**
  * @brief Releases memory allocated by a device.
  *
@@ -172,6 +614,20 @@ PtgModel_SetActiveLayer(PtgModel* model, PtgLayer layer);
 void
 PtgModel_SetBrushSize(PtgModel* model, float brush_size);
 
+/**
+ * @brief Bounds the brush used by the next path, so that it has no effect beyond a certain distance.
+ *        Bounded brushes leave most of a terrain untouched, which sparse outputs take advantage of.
+ *
+ * @param model The model to set the brush radius of.
+ *
+ * @param brush_radius The distance, in meters, beyond which the brush has no effect.
+ *                     A radius of zero means the brush has no bounds, which is the default.
+ *
+ * @ingroup ptg_model
+ */
+void
+PtgModel_SetBrushRadius(PtgModel* model, float brush_radius);
+
 void
 PtgModel_BeginPath(PtgModel* model);
 
@@ -230,6 +686,179 @@ typedef struct ptg_output PtgOutput;
 PtgOutput*
 PtgOutput_New(PtgDevice* device, uint32_t terrain_size);
 
+/**
+ * @brief Used to select how the layers of an output are stored.
+ *
+ * @ingroup ptg_output
+ */
+enum ptg_storage
+{
+  /** The layers are kept entirely in memory. */
+  PTG_STORAGE_MEMORY,
+  /** The layers are kept in temporary files and streamed through memory in tiles, with a bounded memory budget. */
+  PTG_STORAGE_PAGED,
+  /** The layers are kept in memory, but only the tiles that are modified are allocated. */
+  PTG_STORAGE_SPARSE,
+  /**
+   * The layers are kept in memory-mapped files that are updated in place as the output is baked.
+   * The files remain after the output is deleted and can be mapped read only by other processes.
+   *
+   * Each file starts with a 24 byte header: the magic bytes "PTGTEX01", the texture size as a 32-bit unsigned
+   * integer, a 32-bit texel format (zero for four 32-bit floats) and the 64-bit offset of the first texel.
+   * The texels follow as rows of RGBA floats, where each texel holds a 2x2 block of cell heights.
+   */
+  PTG_STORAGE_MAPPED,
+  /**
+   * The layers are kept in memory, compressed in 32x32 blocks as a base height plus packed deltas.
+   * Smooth terrain takes far less memory than with @ref PTG_STORAGE_MEMORY, at the cost of decompressing
+   * blocks as they are baked. The compression is lossless unless a maximum error is given.
+   */
+  PTG_STORAGE_COMPRESSED
+};
+
+/**
+ * @brief A type definition for storage kinds.
+ *
+ * @ingroup ptg_output
+ */
+typedef enum ptg_storage PtgStorage;
+
+/**
+ * @brief Used to select how the texels of layers kept in memory are arranged.
+ *
+ * @ingroup ptg_output
+ */
+enum ptg_texel_layout
+{
+  /** Texels are stored one row after another. */
+  PTG_TEXEL_LAYOUT_LINEAR,
+  /** Texels are stored in 32x32 blocks, which is faster for kernels that access neighbouring texels. */
+  PTG_TEXEL_LAYOUT_TILED
+};
+
+/**
+ * @brief A type definition for texel layouts.
+ *
+ * @ingroup ptg_output
+ */
+typedef enum ptg_texel_layout PtgTexelLayout;
+
+/**
+ * @brief Used to select the precision that layers kept in memory are stored with.
+ *
+ * @ingroup ptg_output
+ */
+enum ptg_texel_format
+{
+  /** Heights are stored as 32-bit floats. */
+  PTG_TEXEL_FORMAT_FLOAT32,
+  /** Heights are stored as 16-bit (half precision) floats, which halves the memory used by the layers. */
+  PTG_TEXEL_FORMAT_FLOAT16,
+  /**
+   * Heights are stored as 16-bit unsigned integers, spread evenly over a range given by a scale and offset.
+   * Heights outside of the range are clamped.
+   */
+  PTG_TEXEL_FORMAT_UNORM16
+};
+
+/**
+ * @brief A type definition for texel formats.
+ *
+ * @ingroup ptg_output
+ */
+typedef enum ptg_texel_format PtgTexelFormat;
+
+/**
+ * @brief Options for outputs whose layers are stored in memory-mapped files.
+ *
+ * @ingroup ptg_output
+ */
+enum ptg_map_flags
+{
+  /** Fault in every page of the layer files when they are created, instead of on first access. */
+  PTG_MAP_POPULATE = 1,
+  /** Ask for the layer files to be mapped with huge pages, where the file system supports it. */
+  PTG_MAP_HUGE_PAGES = 2
+};
+
+/**
+ * @brief Options for creating an output.
+ *        Initialize with @ref PtgOutputOptions_Init before setting fields, so that new fields get default values.
+ *
+ * @ingroup ptg_output
+ */
+struct ptg_output_options
+{
+  /** How the layers of the output are stored. */
+  PtgStorage storage;
+
+  /** For memory storage, how the texels of each layer are arranged. Only applies to 32-bit float layers. */
+  PtgTexelLayout layout;
+
+  /** For memory storage, the precision that heights are stored with. */
+  PtgTexelFormat format;
+
+  /** For 16-bit unsigned normalized layers, the height range that can be stored, in meters. */
+  float format_scale;
+
+  /** For 16-bit unsigned normalized layers, the lowest height that can be stored, in meters. */
+  float format_offset;
+
+  /** For paged storage, the number of bytes of layer tiles that may be kept in memory. */
+  uint64_t memory_budget;
+
+  /** For paged storage, the directory to create the backing files in. If null, the temporary directory is used. */
+  const char* page_directory;
+
+  /**
+   * For mapped storage, the path that the layer files are named after.
+   * The rock and soil layers are stored at this path with ".rock" and ".soil" appended.
+   */
+  const char* mapped_path;
+
+  /** For mapped storage, a combination of @ref ptg_map_flags. */
+  uint32_t map_flags;
+
+  /**
+   * For compressed storage, the largest error allowed in each stored height, in meters.
+   * A value of zero makes the compression lossless.
+   */
+  float max_error;
+};
+
+/**
+ * @brief A type definition for output options.
+ *
+ * @ingroup ptg_output
+ */
+typedef struct ptg_output_options PtgOutputOptions;
+
+/**
+ * @brief Assigns the default values to a set of output options.
+ *
+ * @param options The options to initialize.
+ *
+ * @ingroup ptg_output
+ */
+void
+PtgOutputOptions_Init(PtgOutputOptions* options);
+
+/**
+ * @brief Used to get usable terrain data, with control over how the terrain is stored.
+ *
+ * @param device The device to create the terrain output with.
+ *
+ * @param terrain_size The size of the output terrain.
+ *
+ * @param options The options to create the output with.
+ *
+ * @return A new instance of a terrain output data.
+ *
+ * @ingroup ptg_output
+ */
+PtgOutput*
+PtgOutput_NewWithOptions(PtgDevice* device, uint32_t terrain_size, const PtgOutputOptions* options);
+
 /**
  * @brief Releases memory allocated by an output object.
  *
@@ -248,6 +877,7 @@ PtgOutput_Delete(PtgOutput* output);
  * @param model The model to bake.
  *
  * @returns The total number of steps required for the bake operation.
+ *          If the model has nothing to bake, this is zero and no bake job is started.
  *
  * @ingroup ptg_output
  */
@@ -282,6 +912,115 @@ PtgOutput_IterateBake(PtgOutput* output);
 bool
 PtgOutput_SaveHeightPng(PtgOutput* output, const char* path, ptg_write_png png_write_function);
 
+/**
+ * @brief Reads the memory held by the layer textures of an output.
+ *        The allocation count includes the textures that replaced layers during bakes.
+ *
+ * @param output The output to read the memory statistics of.
+ *
+ * @param stats Assigned the memory statistics of the output.
+ *
+ * @ingroup ptg_output
+ */
+void
+PtgOutput_GetMemoryStats(PtgOutput* output, PtgMemoryStats* stats);
+
+/*************
+ * Chunk API *
+ *************/
+
+/**
+ * @defgroup ptg_chunk Chunk API
+ *
+ * @brief The API for baking terrains that extend beyond a single output.
+ *
+ * @details The world is divided into a grid of fixed-size chunks, where each chunk covers the same area that a
+ *          single output covers. Chunks are baked on demand and kept in a cache with a bounded memory footprint.
+ */
+
+/**
+ * @brief The type for a chunk cache.
+ *
+ * @ingroup ptg_chunk
+ */
+typedef struct ptg_chunk_cache PtgChunkCache;
+
+/**
+ * @brief Creates a new chunk cache.
+ *
+ * @param device The device to bake the chunks with.
+ *
+ * @param chunk_size The size of each chunk, in cells per axis. This must be a non-zero multiple of 8.
+ *
+ * @param memory_budget The maximum number of bytes that baked chunks may occupy.
+ *                      Once exceeded, the least recently used chunks are released.
+ *
+ * @return A new chunk cache, or null if the chunk size is not valid (in which case an error is logged).
+ *
+ * @ingroup ptg_chunk
+ */
+PtgChunkCache*
+PtgChunkCache_New(PtgDevice* device, uint32_t chunk_size, uint64_t memory_budget);
+
+/**
+ * @brief Releases memory allocated by a chunk cache.
+ *
+ * @param cache The chunk cache to release the memory of.
+ *
+ * @ingroup ptg_chunk
+ */
+void
+PtgChunkCache_Delete(PtgChunkCache* cache);
+
+/**
+ * @brief Sets the model that chunks are baked from.
+ *        A snapshot of the model is taken, so later edits to the model require calling this function again.
+ *        Any chunks baked from the previous model are discarded.
+ *
+ * @param cache The chunk cache to assign the model to.
+ *
+ * @param model The model to bake chunks from.
+ *
+ * @ingroup ptg_chunk
+ */
+void
+PtgChunkCache_SetModel(PtgChunkCache* cache, PtgModel* model);
+
+/**
+ * @brief Reads the total height of a chunk, baking the chunk first if it is not cached.
+ *
+ * @param cache The chunk cache to get the chunk from.
+ *
+ * @param x The X coordinate of the chunk in the chunk grid.
+ *
+ * @param y The Y coordinate of the chunk in the chunk grid.
+ *
+ * @param heights The array to write the heights to.
+ *                It must have room for the chunk size squared, and is written in row-major order.
+ *
+ * @ingroup ptg_chunk
+ */
+void
+PtgChunkCache_ReadHeight(PtgChunkCache* cache, int32_t x, int32_t y, float* heights);
+
+/**
+ * @brief Bakes the chunks along the path of a camera, so that they are cached before they are needed.
+ *
+ * @param cache The chunk cache to bake the chunks into.
+ *
+ * @param trajectory The XY positions of the camera, in meters and in the order they will be visited.
+ *
+ * @param point_count The number of points in the trajectory.
+ *
+ * @param radius The number of neighbouring chunks, in each direction, to bake around each point.
+ *
+ * @return The number of chunks that had to be baked.
+ *
+ * @ingroup ptg_chunk
+ */
+uint32_t
+PtgChunkCache_Prefetch(PtgChunkCache* cache, const float* trajectory, uint32_t point_count, uint32_t radius);
+
 /**************
  * Render API *
  **************/
@@ -322,6 +1061,163 @@ PtgRender_Iterate(PtgRender* render);
 void
 PtgRender_SavePng(PtgRender* render, const char* path, ptg_write_png png_writer);
 
+/**
+ * @brief Reads the memory held by the color texture of a render.
+ *
+ * @param render The render to read the memory statistics of.
+ *
+ * @param stats Assigned the memory statistics of the render.
+ *
+ * @ingroup ptg_render
+ */
+void
+PtgRender_GetMemoryStats(PtgRender* render, PtgMemoryStats* stats);
+
+/********************
+ * Command list API *
+ ********************/
+
+/**
+ * @defgroup ptg_command_list Command list API
+ *
+ * @brief The API for recording work and executing it in a single call.
+ *
+ * @details Commands for the same output or render are executed in the order they were recorded. Commands for
+ *          different objects are independent, so they may be executed at the same time. Consecutive bake steps or
+ *          render samples for the same object are merged as they are recorded.
+ *
+ *          Objects referenced by a command list must stay alive until the list is deleted or reset, and must not be
+ *          used by other threads while the list is being submitted.
+ */
+
+/**
+ * @brief A type definition for a command list.
+ *
+ * @ingroup ptg_command_list
+ */
+typedef struct ptg_command_list PtgCommandList;
+
+/**
+ * @brief Creates a new, empty command list.
+ *
+ * @param device The device to execute the commands with.
+ *
+ * @return A new command list.
+ *
+ * @ingroup ptg_command_list
+ */
+PtgCommandList*
+PtgCommandList_New(PtgDevice* device);
+
+/**
+ * @brief Releases memory allocated by a command list.
+ *
+ * @param list The command list to release the memory of.
+ *
+ * @ingroup ptg_command_list
+ */
+void
+PtgCommandList_Delete(PtgCommandList* list);
+
+/**
+ * @brief Removes every command from a command list.
+ *
+ * @param list The command list to reset.
+ *
+ * @ingroup ptg_command_list
+ */
+void
+PtgCommandList_Reset(PtgCommandList* list);
+
+/**
+ * @brief Records preparing an output to bake a model.
+ *        A snapshot of the model is taken when this is called, so later edits to the model are not baked.
+ *
+ * @param list The command list to record into.
+ *
+ * @param output The output to bake the model into.
+ *
+ * @param model The model to bake.
+ *
+ * @ingroup ptg_command_list
+ */
+void
+PtgCommandList_PrepareBake(PtgCommandList* list, PtgOutput* output, PtgModel* model);
+
+/**
+ * @brief Records steps of the bake job of an output. Steps past the end of the bake job do nothing.
+ *
+ * @param list The command list to record into.
+ *
+ * @param output The output being baked.
+ *
+ * @param step_count The number of steps to take.
+ *                   The value returned by @ref PtgOutput_PrepareBake can be used to record the whole bake job.
+ *
+ * @ingroup ptg_command_list
+ */
+void
+PtgCommandList_IterateBake(PtgCommandList* list, PtgOutput* output, uint32_t step_count);
+
+/**
+ * @brief Records saving the total height of an output as a PNG file.
+ *
+ * @param list The command list to record into.
+ *
+ * @param output The output to save the height map of.
+ *
+ * @param path The path to save the file at. The path is copied.
+ *
+ * @param png_writer The function used to write PNG files.
+ *
+ * @ingroup ptg_command_list
+ */
+void
+PtgCommandList_SaveHeightPng(PtgCommandList* list, PtgOutput* output, const char* path, ptg_write_png png_writer);
+
+/**
+ * @brief Records rendering samples of a render.
+ *
+ * @param list The command list to record into.
+ *
+ * @param render The render to add samples to.
+ *
+ * @param sample_count The number of samples per pixel to render.
+ *
+ * @ingroup ptg_command_list
+ */
+void
+PtgCommandList_IterateRender(PtgCommandList* list, PtgRender* render, uint32_t sample_count);
+
+/**
+ * @brief Records saving a render as a PNG file.
+ *
+ * @param list The command list to record into.
+ *
+ * @param render The render to save.
+ *
+ * @param path The path to save the file at. The path is copied.
+ *
+ * @param png_writer The function used to write PNG files.
+ *
+ * @ingroup ptg_command_list
+ */
+void
+PtgCommandList_SaveRenderPng(PtgCommandList* list, PtgRender* render, const char* path, ptg_write_png png_writer);
+
+/**
+ * @brief Executes the commands of a command list, returning once they are all done.
+ *        The commands are kept, so the same list can be submitted again.
+ *
+ * @param list The command list to execute.
+ *
+ * @return True if every command succeeded, false if any of them failed.
+ *
+ * @ingroup ptg_command_list
+ */
+bool
+PtgCommandList_Submit(PtgCommandList* list);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -0,0 +1,150 @@
+#include "budget_allocator.hpp"
+
+namespace ptg {
+
+budget_allocator::budget_allocator(std::shared_ptr<memory_allocator> allocator)
+  : allocator_(std::move(allocator))
+{
+}
+
+void
+budget_allocator::set_callbacks(reclaim_func reclaim, error_func error)
+{
+  std::lock_guard<std::mutex> guard(lock_);
+
+  reclaim_ = std::move(reclaim);
+
+  error_ = std::move(error);
+}
+
+void
+budget_allocator::set_budget(const uint64_t budget)
+{
+  std::lock_guard<std::mutex> guard(lock_);
+
+  budget_ = budget;
+}
+
+bool
+budget_allocator::reserve(const size_t bytes)
+{
+  reclaim_func reclaim;
+
+  for (int attempt = 0; attempt < 2; attempt++) {
+
+    if (reclaim)
+      reclaim();
+
+    std::lock_guard<std::mutex> guard(lock_);
+
+    if ((budget_ == 0) || ((live_bytes_ + bytes) <= budget_)) {
+      live_bytes_ += bytes;
+      stats_.update(live_bytes_);
+      return true;
+    }
+
+    // Reclaiming may write pages back to their files, so it is done outside of the lock.
+    if (!reclaim_)
+      break;
+
+    reclaim = reclaim_;
+  }
+
+  std::string msg;
+
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+
+    msg = "Failed to allocate " + std::to_string(bytes) + " bytes because the memory budget of " +
+          std::to_string(budget_) + " bytes would be exceeded (" + std::to_string(live_bytes_) +
+          " bytes are in use).";
+  }
+
+  report_error(msg);
+
+  return false;
+}
+
+void
+budget_allocator::release(const size_t bytes)
+{
+  std::lock_guard<std::mutex> guard(lock_);
+
+  live_bytes_ -= bytes;
+
+  stats_.update(live_bytes_);
+}
+
+void*
+budget_allocator::allocate(const size_t size, const size_t alignment)
+{
+  if (!reserve(size))
+    return nullptr;
+
+  auto* data = allocator_->allocate(size, alignment);
+
+  if (!data) {
+    release(size);
+    report_error("Failed to allocate " + std::to_string(size) + " bytes.");
+    return nullptr;
+  }
+
+  stats_.record_allocation();
+
+  return data;
+}
+
+void*
+budget_allocator::reallocate(void* data, const size_t old_size, const size_t new_size, const size_t alignment)
+{
+  // Growth is counted before reallocating, so that it is checked against the budget, and shrinking is counted
+  // after, once the memory is actually given back.
+
+  if ((new_size > old_size) && !reserve(new_size - old_size))
+    return nullptr;
+
+  auto* new_data = allocator_->reallocate(data, old_size, new_size, alignment);
+
+  if (!new_data && (new_size > 0)) {
+    if (new_size > old_size)
+      release(new_size - old_size);
+    report_error("Failed to allocate " + std::to_string(new_size) + " bytes.");
+    return nullptr;
+  }
+
+  if (new_size < old_size)
+    release(old_size - new_size);
+
+  if (!data && new_data)
+    stats_.record_allocation();
+
+  return new_data;
+}
+
+void
+budget_allocator::deallocate(void* data, const size_t size)
+{
+  if (!data)
+    return;
+
+  allocator_->deallocate(data, size);
+
+  release(size);
+}
+
+void
+budget_allocator::report_error(const std::string& msg)
+{
+  error_func error;
+
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+
+    error = error_;
+  }
+
+  if (error)
+    error(msg);
+}
+
+} // namespace ptg
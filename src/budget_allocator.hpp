@@ -0,0 +1,88 @@
+#pragma once
+
+#include "device_stats.hpp"
+#include "texel_allocator.hpp"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace ptg {
+
+/// @brief An allocator that counts the memory held through another allocator, and keeps it within a budget.
+///
+/// @details Every allocation that a device makes goes through one of these: texel storage, tiles allocated as sparse
+///          textures are written, blocks that grow as compressed textures are encoded, tiles copied out of shared
+///          storage, pages loaded by page caches and buffers. The budget is checked and the bytes are counted under
+///          a single lock, so allocations made from several threads at once can not exceed it together.
+class budget_allocator final : public memory_allocator
+{
+public:
+  /// @brief Called without the lock held when an allocation does not fit in the budget, to release memory held
+  ///        elsewhere (such as pages kept by page caches) before the allocation is tried again.
+  using reclaim_func = std::function<void()>;
+
+  /// @brief Called without the lock held when an allocation fails, with a message saying why.
+  using error_func = std::function<void(const std::string& msg)>;
+
+  /// @brief Constructs a new budget allocator, without a budget.
+  ///
+  /// @param allocator The allocator to allocate the memory with.
+  explicit budget_allocator(std::shared_ptr<memory_allocator> allocator);
+
+  /// @brief Sets the functions that are called when an allocation does not fit or fails.
+  ///        Either may be null. Allocations can outlive the device that set them, which clears them when it is
+  ///        destroyed.
+  void set_callbacks(reclaim_func reclaim, error_func error);
+
+  /// @brief Sets the largest number of bytes that may be held, or zero for no limit.
+  ///        Memory that is already held is kept, even if it exceeds the new budget.
+  void set_budget(uint64_t budget);
+
+  /// @brief Gets the counters of the memory held through the allocator.
+  [[nodiscard]] const memory_stats& get_stats() const { return stats_; }
+
+  /// @brief Counts memory that is about to be allocated, if it fits in the budget.
+  ///        If it does not, memory is reclaimed once and the budget is checked again.
+  ///
+  /// @param bytes The number of bytes to count.
+  ///
+  /// @return True if the bytes were counted, false if they do not fit (in which case an error is reported).
+  bool reserve(size_t bytes);
+
+  /// @brief Stops counting memory that was counted by @ref budget_allocator::reserve.
+  ///
+  /// @param bytes The number of bytes to stop counting.
+  void release(size_t bytes);
+
+  void* allocate(size_t size, size_t alignment) override;
+
+  void* reallocate(void* data, size_t old_size, size_t new_size, size_t alignment) override;
+
+  void deallocate(void* data, size_t size) override;
+
+private:
+  /// @brief Passes a message to the error function, if there is one.
+  void report_error(const std::string& msg);
+
+  std::shared_ptr<memory_allocator> allocator_;
+
+  /// @brief Guards the budget, the counters and the callbacks.
+  std::mutex lock_;
+
+  uint64_t budget_{ 0 };
+
+  uint64_t live_bytes_{ 0 };
+
+  memory_stats stats_;
+
+  reclaim_func reclaim_;
+
+  error_func error_;
+};
+
+} // namespace ptg
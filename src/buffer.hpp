@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stddef.h>
+
+namespace ptg {
+
+/// @brief A view of the contents of a buffer, as an array of elements.
+template<typename T>
+struct buffer_span final
+{
+  /// @brief A pointer to the first element.
+  T* data{ nullptr };
+
+  /// @brief The number of elements.
+  size_t size{ 0 };
+
+  [[nodiscard]] T* begin() const { return data; }
+
+  [[nodiscard]] T* end() const { return data + size; }
+
+  [[nodiscard]] T& operator[](const size_t index) const { return data[index]; }
+
+  [[nodiscard]] bool empty() const { return size == 0; }
+};
+
+/// @brief The interface for a buffer, which holds variable-length data for kernels, such as lists of points.
+class buffer
+{
+public:
+  buffer() = default;
+
+  buffer(const buffer&) = delete;
+
+  buffer(buffer&&) = delete;
+
+  buffer& operator=(const buffer&) = delete;
+
+  buffer& operator=(buffer&&) = delete;
+
+  virtual ~buffer() = default;
+
+  /// @brief Gets the size of the buffer.
+  ///
+  /// @return The size of the buffer, in bytes.
+  [[nodiscard]] virtual size_t get_size() const = 0;
+
+  /// @brief Maps the contents of the buffer into CPU memory, so that they can be read and written.
+  ///        The buffer must not be used by a dispatch while it is mapped.
+  ///
+  /// @return A pointer to the contents of the buffer, which is aligned for any element type.
+  virtual void* map() = 0;
+
+  /// @brief Releases the pointer returned by @ref buffer::map.
+  virtual void unmap() = 0;
+
+  /// @brief Gets the contents of the buffer as an array of elements.
+  ///        This maps the buffer, so it must be unmapped once the elements are no longer needed.
+  ///
+  /// @return The elements of the buffer. Bytes at the end that do not fill a whole element are left out.
+  template<typename T>
+  buffer_span<T> map_span()
+  {
+    return buffer_span<T>{ static_cast<T*>(map()), get_size() / sizeof(T) };
+  }
+};
+
+} // namespace ptg
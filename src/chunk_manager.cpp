@@ -0,0 +1,253 @@
+#include "chunk_manager.hpp"
+
+#include "scheduler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+#include <vector>
+
+namespace ptg {
+
+chunk_manager::chunk_manager(std::shared_ptr<device> dev, const uint32_t chunk_size, const size_t memory_budget)
+  : device_(std::move(dev))
+    , chunk_size_(chunk_size)
+    , memory_budget_(memory_budget)
+{
+}
+
+void
+chunk_manager::set_model(const model& m)
+{
+  chunks_.clear();
+
+  lru_.clear();
+
+  memory_usage_ = 0;
+
+  memento_ = m.copy_current_memento();
+}
+
+output*
+chunk_manager::get_chunk(const chunk_key key)
+{
+  auto it = chunks_.find(key);
+  if (it != chunks_.end()) {
+    touch(it->second);
+    return it->second.terrain.get();
+  }
+
+  return bake(key);
+}
+
+uint32_t
+chunk_manager::prefetch(const glm::vec2* trajectory, const size_t point_count, const uint32_t radius)
+{
+  // Gather the chunks in the order that the camera reaches them, nearest neighbours first.
+
+  std::vector<chunk_key> keys;
+
+  // The index one past the last key of each ring, in the order the rings are gathered.
+  std::vector<size_t> ring_ends;
+
+  std::unordered_set<chunk_key, chunk_key_hash> visited;
+
+  const auto r = static_cast<int32_t>(radius);
+
+  for (size_t i = 0; i < point_count; i++) {
+
+    const auto center = find_chunk(trajectory[i]);
+
+    for (int32_t ring = 0; ring <= r; ring++) {
+
+      for (int32_t dy = -ring; dy <= ring; dy++) {
+
+        for (int32_t dx = -ring; dx <= ring; dx++) {
+
+          if ((std::abs(dx) != ring) && (std::abs(dy) != ring))
+            continue;
+
+          const chunk_key key{ center.x + dx, center.y + dy };
+
+          if (visited.insert(key).second)
+            keys.emplace_back(key);
+        }
+      }
+
+      ring_ends.emplace_back(keys.size());
+    }
+  }
+
+  // The chunks that are already cached are touched before any baking, so that making room for the new chunks
+  // evicts other chunks first. The chunks reached first are touched last, so that they are the last to be evicted.
+
+  auto touch_cached = [this, &keys](const size_t key_count) {
+    for (auto i = key_count; i > 0; i--) {
+      auto it = chunks_.find(keys[i - 1]);
+      if (it != chunks_.end())
+        touch(it->second);
+    }
+  };
+
+  touch_cached(keys.size());
+
+  // Prefetching more chunks than fit in the cache would only evict the chunks needed first. The number that fit is
+  // estimated from the chunks baked so far, so it is checked again after each batch of bakes. The missing chunks of
+  // a ring are baked together, except that the first chunk is baked alone when no chunk has been baked yet, since
+  // its size is needed to know how many fit.
+
+  uint32_t bake_count = 0;
+
+  size_t key_count = 0;
+
+  size_t ring = 0;
+
+  bool full = false;
+
+  while (!full && (key_count < keys.size())) {
+
+    while (ring_ends[ring] <= key_count)
+      ring++;
+
+    std::vector<chunk_key> missing;
+
+    while (key_count < ring_ends[ring]) {
+
+      if ((chunk_memory_usage_ > 0) && (key_count >= std::max<size_t>(memory_budget_ / chunk_memory_usage_, 1))) {
+        full = true;
+        break;
+      }
+
+      const auto& key = keys[key_count];
+
+      if (chunks_.find(key) == chunks_.end()) {
+
+        if ((chunk_memory_usage_ == 0) && !missing.empty())
+          break;
+
+        missing.emplace_back(key);
+      }
+
+      key_count++;
+    }
+
+    bake_all(missing);
+
+    bake_count += static_cast<uint32_t>(missing.size());
+  }
+
+  // A bake may still have evicted one of the chunks gathered here, if chunks differ in size, so missing chunks are
+  // skipped.
+  touch_cached(key_count);
+
+  return bake_count;
+}
+
+chunk_key
+chunk_manager::find_chunk(const glm::vec2& position) const
+{
+  const auto extent = memento_.meters_per_axis;
+
+  return chunk_key{ static_cast<int32_t>(std::floor(position.x / extent)),
+                    static_cast<int32_t>(std::floor(position.y / extent)) };
+}
+
+output*
+chunk_manager::bake(const chunk_key key)
+{
+  // Room is made up front using the size of the last chunk, and corrected once the size of this one is known.
+  evict(chunk_memory_usage_);
+
+  return insert(key, bake_terrain(key));
+}
+
+void
+chunk_manager::bake_all(const std::vector<chunk_key>& keys)
+{
+  if (keys.empty())
+    return;
+
+  evict(keys.size() * chunk_memory_usage_);
+
+  // Each chunk is baked into its own output, with its own kernel instances, so chunks can be baked in parallel.
+  // The cache is only changed once they are all done.
+
+  std::vector<std::unique_ptr<output>> terrains(keys.size());
+
+  auto bake_chunk = [this, &keys, &terrains](const uint32_t index) { terrains[index] = bake_terrain(keys[index]); };
+
+  auto* sched = device_->get_scheduler();
+
+  if (!sched || (keys.size() == 1)) {
+    for (uint32_t i = 0; i < keys.size(); i++)
+      bake_chunk(i);
+  } else {
+    sched->parallel_for(static_cast<uint32_t>(keys.size()), bake_chunk);
+  }
+
+  for (size_t i = 0; i < keys.size(); i++)
+    insert(keys[i], std::move(terrains[i]));
+}
+
+std::unique_ptr<output>
+chunk_manager::bake_terrain(const chunk_key key) const
+{
+  auto terrain = std::make_unique<output>(device_, chunk_size_);
+
+  const auto extent = memento_.meters_per_axis;
+
+  terrain->set_origin(glm::vec2(static_cast<float>(key.x) * extent, static_cast<float>(key.y) * extent));
+
+  const auto step_count = terrain->prepare_bake(memento_);
+
+  for (uint32_t i = 0; i < step_count; i++)
+    terrain->iterate_bake();
+
+  return terrain;
+}
+
+output*
+chunk_manager::insert(const chunk_key key, std::unique_ptr<output> terrain)
+{
+  const auto bytes = terrain->get_memory_usage();
+
+  if ((chunk_memory_usage_ == 0) && (memory_budget_ < bytes))
+    device_->warn("Chunk memory budget is smaller than a single chunk, only one chunk will be cached at a time.");
+
+  chunk_memory_usage_ = bytes;
+
+  evict(bytes);
+
+  memory_usage_ += bytes;
+
+  lru_.emplace_front(key);
+
+  auto* ptr = terrain.get();
+
+  chunks_.emplace(key, chunk{ std::move(terrain), bytes, lru_.begin() });
+
+  return ptr;
+}
+
+void
+chunk_manager::touch(chunk& c)
+{
+  lru_.splice(lru_.begin(), lru_, c.lru_position);
+}
+
+void
+chunk_manager::evict(const size_t incoming_bytes)
+{
+  while (!lru_.empty() && ((memory_usage_ + incoming_bytes) > memory_budget_)) {
+
+    auto it = chunks_.find(lru_.back());
+
+    memory_usage_ -= it->second.memory_usage;
+
+    chunks_.erase(it);
+
+    lru_.pop_back();
+  }
+}
+
+} // namespace ptg
@@ -0,0 +1,183 @@
+#pragma once
+
+#include "device.hpp"
+#include "model.hpp"
+#include "output.hpp"
+
+#include <glm/glm.hpp>
+
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace ptg {
+
+/// @brief Used to identify a chunk of an infinite terrain.
+struct chunk_key final
+{
+  int32_t x{ 0 };
+
+  int32_t y{ 0 };
+
+  bool operator==(const chunk_key& other) const { return (x == other.x) && (y == other.y); }
+};
+
+/// @brief Bakes an unbounded terrain as a grid of fixed-size chunks.
+///
+/// @details Each chunk is an output whose origin is placed at its position in the grid, so model operations that
+///          cross chunk borders are evaluated at the same world positions on either side of the seam.
+///          Baked chunks are kept in a cache that evicts the least recently used chunk once the memory budget is
+///          exceeded.
+class chunk_manager final
+{
+public:
+  /// @brief Constructs a new chunk manager.
+  ///
+  /// @param dev The device to bake the chunks with.
+  ///
+  /// @param chunk_size The size of each chunk, in cells per axis.
+  ///
+  /// @param memory_budget The maximum number of bytes that baked chunks may occupy.
+  chunk_manager(std::shared_ptr<device> dev, uint32_t chunk_size, size_t memory_budget);
+
+  /// @brief Checks whether chunks can be baked at a given size.
+  ///        Each texel of a chunk holds 2x2 cells, and chunks are dispatched in whole work groups of texels, so the
+  ///        size must be a non-zero multiple of 8.
+  ///
+  /// @param chunk_size The size of each chunk, in cells per axis.
+  ///
+  /// @return True if the size can be used, false otherwise.
+  static bool is_valid_chunk_size(uint32_t chunk_size) { return (chunk_size > 0) && ((chunk_size % 8) == 0); }
+
+  /// @brief Sets the model that chunks are baked from.
+  ///        This takes a snapshot of the model and discards all chunks baked from the previous one.
+  ///
+  /// @param m The model to bake chunks from.
+  void set_model(const model& m);
+
+  /// @brief Gets a baked chunk, baking it first if it is not in the cache.
+  ///
+  /// @param key The coordinates of the chunk to get.
+  ///
+  /// @return A pointer to the baked chunk.
+  ///         The pointer remains valid until the chunk is evicted by a later call to this class.
+  output* get_chunk(chunk_key key);
+
+  /// @brief Bakes the chunks that a camera will pass over, so that they are cached before they are needed.
+  ///        Chunks are baked in the order they are reached and prefetching stops once the cache is full.
+  ///        The missing chunks of each ring around a point are baked in parallel, through the scheduler of the
+  ///        device, and are then added to the cache on the calling thread.
+  ///
+  /// @param trajectory The positions of the camera, in world space and in the order they will be visited.
+  ///
+  /// @param point_count The number of points in the trajectory.
+  ///
+  /// @param radius The number of neighbouring chunks, in each direction, to bake around each point.
+  ///
+  /// @return The number of chunks that had to be baked.
+  uint32_t prefetch(const glm::vec2* trajectory, size_t point_count, uint32_t radius);
+
+  /// @brief Gets the chunk containing a point in world space.
+  ///
+  /// @param position The position to get the chunk of, in meters.
+  ///
+  /// @return The key of the chunk containing the position.
+  [[nodiscard]] chunk_key find_chunk(const glm::vec2& position) const;
+
+  /// @brief Gets the number of bytes occupied by cached chunks.
+  ///
+  /// @return The number of bytes occupied by cached chunks.
+  [[nodiscard]] size_t get_memory_usage() const { return memory_usage_; }
+
+private:
+  struct chunk_key_hash final
+  {
+    size_t operator()(const chunk_key& key) const
+    {
+      return std::hash<uint64_t>()((static_cast<uint64_t>(static_cast<uint32_t>(key.x)) << 32) |
+                                   static_cast<uint32_t>(key.y));
+    }
+  };
+
+  /// @brief A chunk that has been baked.
+  struct chunk final
+  {
+    /// @brief The output containing the chunk terrain.
+    std::unique_ptr<output> terrain;
+
+    /// @brief The number of bytes the chunk occupied once baked, which is what is given back when it is evicted.
+    size_t memory_usage{ 0 };
+
+    /// @brief The position of the chunk in the list of recently used chunks.
+    std::list<chunk_key>::iterator lru_position;
+  };
+
+  /// @brief Bakes a chunk and inserts it into the cache.
+  ///
+  /// @param key The chunk to bake.
+  ///
+  /// @return The output containing the baked chunk.
+  output* bake(chunk_key key);
+
+  /// @brief Bakes several chunks at once, spread across the scheduler of the device, and inserts them into the
+  ///        cache in the order they are given.
+  ///
+  /// @param keys The chunks to bake, none of which may be cached.
+  void bake_all(const std::vector<chunk_key>& keys);
+
+  /// @brief Bakes a chunk into a new output, without touching the cache.
+  ///        This may be called from several threads at once.
+  ///
+  /// @param key The chunk to bake.
+  ///
+  /// @return The output containing the baked chunk.
+  [[nodiscard]] std::unique_ptr<output> bake_terrain(chunk_key key) const;
+
+  /// @brief Inserts a baked chunk into the cache as the most recently used one, evicting other chunks to make room.
+  ///
+  /// @param key The chunk that was baked.
+  ///
+  /// @param terrain The output containing the baked chunk.
+  ///
+  /// @return The output containing the baked chunk.
+  output* insert(chunk_key key, std::unique_ptr<output> terrain);
+
+  /// @brief Marks a cached chunk as the most recently used one.
+  void touch(chunk& c);
+
+  /// @brief Evicts chunks until there is room for an additional number of bytes.
+  ///
+  /// @param incoming_bytes The number of bytes that need to fit in the budget.
+  void evict(size_t incoming_bytes);
+
+  /// @brief The device that chunks are baked with.
+  std::shared_ptr<device> device_;
+
+  /// @brief The size of each chunk, in cells per axis.
+  uint32_t chunk_size_{ 0 };
+
+  /// @brief The maximum number of bytes that cached chunks may occupy.
+  size_t memory_budget_{ 0 };
+
+  /// @brief The number of bytes occupied by cached chunks.
+  size_t memory_usage_{ 0 };
+
+  /// @brief The number of bytes that the most recently baked chunk occupies, or zero before the first bake.
+  ///        This is used to estimate how many chunks fit in the budget.
+  size_t chunk_memory_usage_{ 0 };
+
+  /// @brief The snapshot of the model that chunks are baked from.
+  memento memento_;
+
+  /// @brief The cached chunks, from the most recently used to the least recently used.
+  std::list<chunk_key> lru_;
+
+  /// @brief The cached chunks.
+  std::unordered_map<chunk_key, chunk, chunk_key_hash> chunks_;
+};
+
+} // namespace ptg
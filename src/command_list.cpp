@@ -0,0 +1,162 @@
+#include "command_list.hpp"
+
+#include "output.hpp"
+#include "render.hpp"
+#include "scheduler.hpp"
+#include "trace.hpp"
+
+#include <atomic>
+#include <unordered_map>
+
+namespace ptg {
+
+command_list::command_list(std::shared_ptr<device> dev)
+  : device_(std::move(dev))
+{
+}
+
+void
+command_list::prepare_bake(output& o, const model& m)
+{
+  command c;
+  c.type = command_type::prepare_bake;
+  c.target_output = &o;
+  c.snapshot = m.copy_current_memento();
+  commands_.emplace_back(std::move(c));
+}
+
+void
+command_list::iterate_bake(output& o, const uint32_t step_count)
+{
+  command c;
+  c.type = command_type::iterate_bake;
+  c.target_output = &o;
+  c.count = step_count;
+  record_iteration(std::move(c));
+}
+
+void
+command_list::save_height_png(output& o, const char* path, ptg_write_png png_writer)
+{
+  command c;
+  c.type = command_type::save_height_png;
+  c.target_output = &o;
+  c.path = path;
+  c.png_writer = png_writer;
+  commands_.emplace_back(std::move(c));
+}
+
+void
+command_list::iterate_render(render& r, const uint32_t sample_count)
+{
+  command c;
+  c.type = command_type::iterate_render;
+  c.target_render = &r;
+  c.count = sample_count;
+  record_iteration(std::move(c));
+}
+
+void
+command_list::save_render_png(render& r, const char* path, ptg_write_png png_writer)
+{
+  command c;
+  c.type = command_type::save_render_png;
+  c.target_render = &r;
+  c.path = path;
+  c.png_writer = png_writer;
+  commands_.emplace_back(std::move(c));
+}
+
+void
+command_list::record_iteration(command c)
+{
+  if (c.count == 0)
+    return;
+
+  if (!commands_.empty()) {
+
+    auto& previous = commands_.back();
+
+    if ((previous.type == c.type) && (previous.get_target() == c.get_target())) {
+      previous.count += c.count;
+      return;
+    }
+  }
+
+  commands_.emplace_back(std::move(c));
+}
+
+bool
+command_list::submit()
+{
+  const trace_scope scope(device_->get_trace(), "submit command list", "command list");
+
+  // Each object gets a chain of the commands that apply to it, in the order they were recorded.
+
+  std::vector<std::vector<command*>> chains;
+
+  std::unordered_map<const void*, size_t> chain_indices;
+
+  for (auto& c : commands_) {
+
+    auto it = chain_indices.find(c.get_target());
+
+    if (it == chain_indices.end()) {
+      it = chain_indices.emplace(c.get_target(), chains.size()).first;
+      chains.emplace_back();
+    }
+
+    chains[it->second].emplace_back(&c);
+  }
+
+  std::atomic<bool> success{ true };
+
+  auto run_chain = [&chains, &success](const uint32_t chain_index) {
+    for (auto* c : chains[chain_index]) {
+      if (!execute(*c))
+        success = false;
+    }
+  };
+
+  auto* sched = device_->get_scheduler();
+
+  if (!sched || (chains.size() == 1)) {
+    for (uint32_t i = 0; i < chains.size(); i++)
+      run_chain(i);
+  } else {
+    sched->parallel_for(static_cast<uint32_t>(chains.size()), run_chain);
+  }
+
+  return success;
+}
+
+bool
+command_list::execute(command& c)
+{
+  switch (c.type) {
+    case command_type::prepare_bake: {
+      // An output can only have one bake job at a time, in which case preparing reports the error and fails.
+      const bool was_baking = c.target_output->has_bake_job();
+      c.target_output->prepare_bake(c.snapshot);
+      return !was_baking;
+    }
+    case command_type::iterate_bake:
+      for (uint32_t i = 0; (i < c.count) && c.target_output->has_bake_job(); i++) {
+        if (!c.target_output->iterate_bake())
+          return false;
+      }
+      return true;
+    case command_type::save_height_png:
+      return c.target_output->save_height_png(c.path.c_str(), c.png_writer);
+    case command_type::iterate_render:
+      for (uint32_t i = 0; i < c.count; i++)
+        c.target_render->iterate();
+      return true;
+    case command_type::save_render_png:
+      return c.target_render->save_to_png(c.path.c_str(), c.png_writer);
+  }
+
+  return false;
+}
+
+} // namespace ptg
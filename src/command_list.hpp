@@ -0,0 +1,141 @@
+#pragma once
+
+#include "device.hpp"
+#include "model.hpp"
+
+#include <ptg.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+namespace ptg {
+
+class output;
+class render;
+
+/// @brief Records work for outputs and renders, to be executed later in a single call.
+///
+/// @details Commands for the same object are executed in the order they were recorded. Commands for different
+///          objects do not depend on each other, so each object's commands are executed as a separate chain, and the
+///          chains run in parallel on the scheduler of the device. Consecutive steps of the same kind for the same
+///          object are merged into a single command as they are recorded.
+class command_list final
+{
+public:
+  /// @brief Constructs a new, empty command list.
+  ///
+  /// @param dev The device whose scheduler executes the commands.
+  explicit command_list(std::shared_ptr<device> dev);
+
+  /// @brief Records preparing an output to bake a snapshot of a model.
+  ///        The snapshot is taken now, so later edits to the model do not affect the recorded command.
+  ///        The command fails if the output still has a bake job when it is executed.
+  ///
+  /// @param o The output to bake into.
+  ///
+  /// @param m The model to bake.
+  void prepare_bake(output& o, const model& m);
+
+  /// @brief Records steps of the bake job of an output. Steps past the end of the job do nothing.
+  ///
+  /// @param o The output being baked.
+  ///
+  /// @param step_count The number of steps to take.
+  void iterate_bake(output& o, uint32_t step_count);
+
+  /// @brief Records saving the total height of an output to a PNG file.
+  ///
+  /// @param o The output to save the height of.
+  ///
+  /// @param path The path to save the file at.
+  ///
+  /// @param png_writer Used to write the PNG file.
+  void save_height_png(output& o, const char* path, ptg_write_png png_writer);
+
+  /// @brief Records rendering samples of a render.
+  ///
+  /// @param r The render to add samples to.
+  ///
+  /// @param sample_count The number of samples per pixel to render.
+  void iterate_render(render& r, uint32_t sample_count);
+
+  /// @brief Records saving a render to a PNG file.
+  ///
+  /// @param r The render to save.
+  ///
+  /// @param path The path to save the file at.
+  ///
+  /// @param png_writer Used to write the PNG file.
+  void save_render_png(render& r, const char* path, ptg_write_png png_writer);
+
+  /// @brief Removes every recorded command.
+  void reset() { commands_.clear(); }
+
+  /// @brief Gets the number of recorded commands, after merging.
+  ///
+  /// @return The number of recorded commands.
+  [[nodiscard]] size_t get_command_count() const { return commands_.size(); }
+
+  /// @brief Executes the recorded commands. The commands are kept, so the list can be submitted again.
+  ///
+  /// @return True if every command succeeded, false if any of them failed.
+  bool submit();
+
+private:
+  /// @brief The kinds of commands that can be recorded.
+  enum class command_type
+  {
+    prepare_bake,
+    iterate_bake,
+    save_height_png,
+    iterate_render,
+    save_render_png
+  };
+
+  /// @brief A single recorded command.
+  struct command final
+  {
+    command_type type{ command_type::iterate_bake };
+
+    /// @brief For output commands, the output the command applies to.
+    output* target_output{ nullptr };
+
+    /// @brief For render commands, the render the command applies to.
+    render* target_render{ nullptr };
+
+    /// @brief For bake preparation, the snapshot of the model to bake.
+    memento snapshot;
+
+    /// @brief For iteration commands, the number of steps or samples to run.
+    uint32_t count{ 0 };
+
+    /// @brief For commands that save files, the path of the file.
+    std::string path;
+
+    /// @brief For commands that save files, the function used to write the PNG file.
+    ptg_write_png png_writer{ nullptr };
+
+    /// @brief Gets the object that the command applies to, which identifies the chain it belongs to.
+    [[nodiscard]] const void* get_target() const
+    {
+      return target_output ? static_cast<const void*>(target_output) : static_cast<const void*>(target_render);
+    }
+  };
+
+  /// @brief Records an iteration command, merging it into the previous command if it iterates the same object.
+  void record_iteration(command c);
+
+  /// @brief Executes a single command.
+  ///
+  /// @return True on success, false on failure.
+  static bool execute(command& c);
+
+  std::shared_ptr<device> device_;
+
+  std::vector<command> commands_;
+};
+
+} // namespace ptg
@@ -0,0 +1,378 @@
+#include "compressed_texture.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <memory>
+
+namespace ptg {
+
+namespace {
+
+constexpr uint32_t block_texel_count = compressed_texture::block_size() * compressed_texture::block_size();
+
+/// @brief The largest magnitude, in quantization steps, that a value may have before a channel falls back to lossless.
+constexpr double max_quantized_value = 2147483647.0;
+
+/// @brief Allocates a tile that a block is decompressed into, from the scratch arena of the calling thread.
+glm::vec4*
+allocate_scratch_tile()
+{
+  return scratch_arena::get_thread_arena().allocate_array<glm::vec4>(block_texel_count);
+}
+
+uint32_t
+float_bits(const float value)
+{
+  uint32_t bits = 0;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+float
+bits_float(const uint32_t bits)
+{
+  float value = 0;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+uint8_t
+get_bit_width(uint32_t value)
+{
+  uint8_t width = 0;
+
+  while (value) {
+    width++;
+    value >>= 1;
+  }
+
+  return width;
+}
+
+void
+write_bits(uint64_t* bits, const size_t bit_offset, const uint32_t value, const uint8_t width)
+{
+  const auto word = bit_offset / 64;
+  const auto shift = bit_offset % 64;
+
+  bits[word] |= static_cast<uint64_t>(value) << shift;
+
+  if ((shift + width) > 64)
+    bits[word + 1] |= static_cast<uint64_t>(value) >> (64 - shift);
+}
+
+uint32_t
+read_bits(const uint64_t* bits, const size_t bit_offset, const uint8_t width)
+{
+  const auto word = bit_offset / 64;
+  const auto shift = bit_offset % 64;
+
+  uint64_t value = bits[word] >> shift;
+
+  if ((shift + width) > 64)
+    value |= bits[word + 1] << (64 - shift);
+
+  return static_cast<uint32_t>(value & ((uint64_t(1) << width) - 1));
+}
+
+} // namespace
+
+compressed_texture::compressed_texture(const uint32_t size,
+                                       const float max_error,
+                                       std::shared_ptr<memory_allocator> allocator)
+  : size_(size)
+    , max_error_(max_error)
+    , blocks_per_axis_((size + block_size() - 1) / block_size())
+    , allocator_(std::move(allocator))
+    , blocks_(static_cast<size_t>(blocks_per_axis_) * blocks_per_axis_)
+{
+}
+
+compressed_texture::~compressed_texture()
+{
+  for (auto& b : blocks_)
+    resize_words(b, 0);
+}
+
+void
+compressed_texture::read_data(float* data)
+{
+  const scratch_arena::scope scratch_scope(scratch_arena::get_thread_arena());
+
+  auto* scratch = allocate_scratch_tile();
+
+  for (uint32_t by = 0; by < blocks_per_axis_; by++) {
+
+    for (uint32_t bx = 0; bx < blocks_per_axis_; bx++) {
+
+      decode(blocks_[(static_cast<size_t>(by) * blocks_per_axis_) + bx], scratch);
+
+      const glm::uvec2 origin(bx * block_size(), by * block_size());
+
+      const auto extent = glm::min(glm::uvec2(block_size()), glm::uvec2(size_) - origin);
+
+      for (uint32_t y = 0; y < extent.y; y++) {
+        auto* dst = &data[((static_cast<size_t>(origin.y + y) * size_) + origin.x) * 4];
+        std::memcpy(dst, &scratch[y * block_size()], extent.x * sizeof(glm::vec4));
+      }
+    }
+  }
+}
+
+texture_desc
+compressed_texture::get_desc() const
+{
+  texture_desc desc;
+  desc.size = size_;
+  desc.storage = texture_storage::compressed;
+  desc.max_error = max_error_;
+  return desc;
+}
+
+texel_tile
+compressed_texture::map_region(const glm::uvec2 origin, const glm::uvec2 size, const tile_access access)
+{
+  auto* scratch = allocate_scratch_tile();
+
+  const auto block_origin = origin - (origin % block_size());
+
+  // Regions smaller than the block still need the rest of the block, since the whole block is encoded on unmap.
+  if ((access != tile_access::write_only) || !is_full_block(origin, size)) {
+    decode(get_block(origin), scratch);
+  } else if ((size.x < block_size()) || (size.y < block_size())) {
+    // Blocks on the edge of the texture are also encoded whole, so the texels past the edge are cleared rather than
+    // left as whatever the arena held before.
+    for (uint32_t y = 0; y < block_size(); y++) {
+      const uint32_t x_start = (y < size.y) ? size.x : 0;
+      std::fill(scratch + (y * block_size()) + x_start, scratch + ((y + 1) * block_size()), glm::vec4(0.0f));
+    }
+  }
+
+  const auto offset = origin - block_origin;
+
+  return texel_tile{ scratch + (offset.y * block_size()) + offset.x, origin, size, block_size() };
+}
+
+void
+compressed_texture::unmap_region(const texel_tile& tile, const tile_access access)
+{
+  const auto offset = tile.origin % block_size();
+
+  auto* scratch = tile.data - ((offset.y * block_size()) + offset.x);
+
+  // The scratch tile is released along with the scope of the arena that it was allocated in.
+  if (access != tile_access::read_only)
+    encode(scratch, get_block(tile.origin));
+}
+
+bool
+compressed_texture::is_constant(const glm::uvec2 origin, const glm::uvec2 size, glm::vec4* value)
+{
+  (void)size;
+
+  const auto& b = get_block(origin);
+
+  for (const auto& header : b.channels) {
+    if (header.bit_width != 0)
+      return false;
+  }
+
+  for (int c = 0; c < 4; c++)
+    (*value)[c] = decode_value(b.channels[c], 0);
+
+  return true;
+}
+
+void
+compressed_texture::fill_region(const glm::uvec2 origin, const glm::uvec2 size, const glm::vec4& value)
+{
+  if (!is_full_block(origin, size)) {
+    texture::fill_region(origin, size, value);
+    return;
+  }
+
+  auto& b = get_block(origin);
+
+  for (int c = 0; c < 4; c++)
+    b.channels[c] = channel_header{ float_bits(value[c]), 0.0f, 0, true };
+
+  resize_words(b, 0);
+}
+
+size_t
+compressed_texture::get_memory_usage() const
+{
+  return (blocks_.size() * sizeof(block)) + (packed_words_.load(std::memory_order_relaxed) * sizeof(uint64_t));
+}
+
+size_t
+compressed_texture::get_compressed_size() const
+{
+  size_t total = 0;
+
+  for (const auto& b : blocks_)
+    total += sizeof(block) + (b.word_count * sizeof(uint64_t));
+
+  return total;
+}
+
+bool
+compressed_texture::resize_words(block& b, const size_t word_count)
+{
+  if (word_count == b.word_count)
+    return true;
+
+  auto* words = static_cast<uint64_t*>(allocator_->reallocate(
+    b.words, b.word_count * sizeof(uint64_t), word_count * sizeof(uint64_t), alignof(uint64_t)));
+
+  if (!words && (word_count > 0))
+    return false;
+
+  if (word_count > b.word_count)
+    packed_words_.fetch_add(word_count - b.word_count, std::memory_order_relaxed);
+  else
+    packed_words_.fetch_sub(b.word_count - word_count, std::memory_order_relaxed);
+
+  b.words = words;
+  b.word_count = word_count;
+
+  return true;
+}
+
+bool
+compressed_texture::is_full_block(const glm::uvec2 origin, const glm::uvec2 size) const
+{
+  return ((origin % block_size()) == glm::uvec2(0)) &&
+         (size == glm::min(glm::uvec2(block_size()), glm::uvec2(size_) - origin));
+}
+
+compressed_texture::block&
+compressed_texture::get_block(const glm::uvec2 texel)
+{
+  const auto pos = texel / block_size();
+
+  return blocks_[(static_cast<size_t>(pos.y) * blocks_per_axis_) + pos.x];
+}
+
+float
+compressed_texture::decode_value(const channel_header& header, const uint32_t delta)
+{
+  if (header.lossless)
+    return bits_float(header.base ^ delta);
+
+  const auto steps = static_cast<int64_t>(static_cast<int32_t>(header.base)) + delta;
+
+  return static_cast<float>(static_cast<double>(steps) * header.step);
+}
+
+void
+compressed_texture::decode(const block& b, glm::vec4* texels) const
+{
+  size_t bit_offset = 0;
+
+  for (int c = 0; c < 4; c++) {
+
+    const auto& header = b.channels[c];
+
+    for (uint32_t i = 0; i < block_texel_count; i++) {
+
+      const uint32_t delta = header.bit_width ? read_bits(b.words, bit_offset, header.bit_width) : 0;
+
+      bit_offset += header.bit_width;
+
+      texels[i][c] = decode_value(header, delta);
+    }
+  }
+}
+
+void
+compressed_texture::encode(const glm::vec4* texels, block& b)
+{
+  // The headers are only stored once the words have been resized, so that the block keeps its previous contents if
+  // they can not be.
+  channel_header headers[4];
+
+  size_t total_bits = 0;
+
+  for (int c = 0; c < 4; c++) {
+
+    auto& header = headers[c];
+
+    float min_value = texels[0][c];
+    float max_value = texels[0][c];
+
+    uint32_t residuals = 0;
+
+    bool finite = true;
+
+    for (uint32_t i = 0; i < block_texel_count; i++) {
+      const float value = texels[i][c];
+      finite = finite && std::isfinite(value);
+      min_value = (value < min_value) ? value : min_value;
+      max_value = (value > max_value) ? value : max_value;
+      residuals |= float_bits(value) ^ float_bits(texels[0][c]);
+    }
+
+    const double step = static_cast<float>(2.0f * max_error_);
+
+    // Values are quantized onto a grid that is the same for every block, rather than relative to the smallest
+    // value of the block. Decoded values then lie on the grid, so encoding them again does not add more error.
+    const bool quantize = (max_error_ > 0.0f) && finite && (std::fabs(min_value / step) < max_quantized_value) &&
+                          (std::fabs(max_value / step) < max_quantized_value);
+
+    if (quantize) {
+      const auto min_step = std::llround(min_value / step);
+      const auto max_step = std::llround(max_value / step);
+      header.lossless = false;
+      header.base = static_cast<uint32_t>(static_cast<int32_t>(min_step));
+      header.step = static_cast<float>(step);
+      header.bit_width = get_bit_width(static_cast<uint32_t>(max_step - min_step));
+    } else {
+      header.lossless = true;
+      header.base = float_bits(texels[0][c]);
+      header.step = 0.0f;
+      header.bit_width = get_bit_width(residuals);
+    }
+
+    total_bits += static_cast<size_t>(header.bit_width) * block_texel_count;
+  }
+
+  if (!resize_words(b, (total_bits + 63) / 64))
+    return;
+
+  std::copy(std::begin(headers), std::end(headers), std::begin(b.channels));
+
+  std::fill_n(b.words, b.word_count, uint64_t(0));
+
+  size_t bit_offset = 0;
+
+  for (int c = 0; c < 4; c++) {
+
+    const auto& header = b.channels[c];
+
+    if (header.bit_width == 0)
+      continue;
+
+    const auto base = static_cast<int64_t>(static_cast<int32_t>(header.base));
+
+    for (uint32_t i = 0; i < block_texel_count; i++) {
+
+      const float value = texels[i][c];
+
+      uint32_t delta = 0;
+
+      if (header.lossless)
+        delta = float_bits(value) ^ header.base;
+      else
+        delta = static_cast<uint32_t>(std::llround(value / static_cast<double>(header.step)) - base);
+
+      write_bits(b.words, bit_offset, delta, header.bit_width);
+
+      bit_offset += header.bit_width;
+    }
+  }
+}
+
+} // namespace ptg
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "texel_allocator.hpp"
+#include "texture.hpp"
+
+#include <atomic>
+#include <vector>
+
+namespace ptg {
+
+/// @brief A texture that keeps its texels compressed in memory.
+///
+/// @details Texels are grouped into 32x32 blocks. Each channel of a block is stored as a base value followed by
+///          deltas from it, packed with just enough bits to hold the largest delta. Smooth height fields compress
+///          well, and blocks that have never been written to take no space at all.
+///
+///          With a maximum error of zero the compression is lossless: deltas are taken between the bit patterns
+///          of the floats. Otherwise values are quantized to steps of twice the maximum error first, so that every
+///          decoded value is within the maximum error of the value that was written.
+///
+///          Mapping a region decompresses its block into a tile allocated from the scratch arena of the calling
+///          thread, and unmapping it after a write compresses the tile back into the block.
+class compressed_texture final : public texture
+{
+public:
+  /// @brief The size of a block, in both axes.
+  static constexpr uint32_t block_size() { return 32; }
+
+  /// @brief Constructs a new compressed texture, where every texel is zero.
+  ///
+  /// @param size The size of the texture, in both axes.
+  ///
+  /// @param max_error The largest difference allowed between a written value and the value read back.
+  ///                  A value of zero makes the compression lossless.
+  ///
+  /// @param allocator The allocator to allocate the packed deltas with. Blocks are resized through it each time they
+  ///                  are encoded.
+  compressed_texture(uint32_t size,
+                     float max_error,
+                     std::shared_ptr<memory_allocator> allocator = get_default_allocator());
+
+  compressed_texture(const compressed_texture&) = delete;
+
+  ~compressed_texture() override;
+
+  void read_data(float* data) override;
+
+  [[nodiscard]] uint32_t get_size() const override { return size_; }
+
+  [[nodiscard]] texture_desc get_desc() const override;
+
+  [[nodiscard]] size_t get_memory_usage() const override;
+
+  [[nodiscard]] uint32_t get_tile_size() const override { return block_size(); }
+
+  texel_tile map_region(glm::uvec2 origin, glm::uvec2 size, tile_access access) override;
+
+  void unmap_region(const texel_tile& tile, tile_access access) override;
+
+  bool is_constant(glm::uvec2 origin, glm::uvec2 size, glm::vec4* value) override;
+
+  void fill_region(glm::uvec2 origin, glm::uvec2 size, const glm::vec4& value) override;
+
+  void* get_data_pointer() override { return nullptr; }
+
+  [[nodiscard]] const void* get_data_pointer() const override { return nullptr; }
+
+  /// @brief Gets the number of bytes used by the compressed blocks.
+  [[nodiscard]] size_t get_compressed_size() const;
+
+private:
+  /// @brief Describes how one channel of a block is encoded.
+  struct channel_header final
+  {
+    /// @brief The value that deltas are taken from.
+    ///        For lossless channels, this holds the bit pattern of a float.
+    ///        For quantized channels, this holds a signed number of quantization steps.
+    uint32_t base{ 0 };
+
+    /// @brief For quantized channels, the size of each quantization step.
+    float step{ 0.0f };
+
+    /// @brief The number of bits that each delta is packed into.
+    uint8_t bit_width{ 0 };
+
+    /// @brief Whether the deltas are between float bit patterns rather than quantized values.
+    bool lossless{ true };
+  };
+
+  /// @brief A compressed block of texels.
+  struct block final
+  {
+    /// @brief The encoding of each channel.
+    channel_header channels[4];
+
+    /// @brief The packed deltas of every channel, one channel after another.
+    uint64_t* words{ nullptr };
+
+    /// @brief The number of packed words.
+    size_t word_count{ 0 };
+  };
+
+  /// @brief Decodes a single value of a channel.
+  static float decode_value(const channel_header& header, uint32_t delta);
+
+  /// @brief Decompresses a block into a tile of texels.
+  void decode(const block& b, glm::vec4* texels) const;
+
+  /// @brief Compresses a tile of texels into a block.
+  ///        If the block needs more words than can be allocated, it is left as it was and the texels are lost.
+  void encode(const glm::vec4* texels, block& b);
+
+  /// @brief Checks whether a rectangle covers every texel of the block it lies in.
+  [[nodiscard]] bool is_full_block(glm::uvec2 origin, glm::uvec2 size) const;
+
+  /// @brief Gets the block containing a texel.
+  [[nodiscard]] block& get_block(glm::uvec2 texel);
+
+  /// @brief Resizes the packed words of a block, leaving their contents undefined.
+  ///
+  /// @return True if the words were resized, false if they could not be allocated (in which case they are left as
+  ///         they were).
+  bool resize_words(block& b, size_t word_count);
+
+  const uint32_t size_{ 0 };
+
+  const float max_error_{ 0.0f };
+
+  const uint32_t blocks_per_axis_{ 0 };
+
+  std::shared_ptr<memory_allocator> allocator_;
+
+  std::vector<block> blocks_;
+
+  /// @brief The number of packed words across all blocks, kept so that memory usage can be read while blocks are
+  ///        being encoded on other threads.
+  std::atomic<size_t> packed_words_{ 0 };
+};
+
+} // namespace ptg
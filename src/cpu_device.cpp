@@ -1,11 +1,32 @@
 #include "cpu_device.hpp"
 
-#include "texture.hpp"
+#include "budget_allocator.hpp"
+#include "compressed_texture.hpp"
+#include "device_stats.hpp"
+#include "host_allocator.hpp"
+#include "host_scheduler.hpp"
 #include "kernel_registry.hpp"
+#include "log_queue.hpp"
+#include "mapped_texture.hpp"
+#include "packed_texture.hpp"
+#include "paged_texture.hpp"
+#include "sparse_texture.hpp"
+#include "texel_allocator.hpp"
+#include "texture.hpp"
+#include "thread_pool.hpp"
+#include "trace.hpp"
 
 #include "kernels/raise_kernel.hpp"
 #include "kernels/render_kernel.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 
 namespace ptg {
@@ -15,66 +36,447 @@ namespace {
 class cpu_texture final : public texture
 {
 public:
-  explicit cpu_texture(const uint32_t size)
+  /// @brief The size of the tiles that kernels process linear textures in.
+  ///        Rows are stored contiguously, so this only affects how work is split up.
+  static constexpr uint32_t tile_size() { return 64; }
+
+  /// @brief The size of the blocks that tiled textures are stored in.
+  ///        A block of 32x32 texels is 16 KiB, which leaves room in the L1 cache for the blocks of other textures.
+  static constexpr uint32_t block_size() { return 32; }
+
+  /// @brief Constructs a new texture, where every texel is zero.
+  ///
+  /// @param sched If not null, the scheduler that kernels are dispatched on.
+  ///              The texels are zeroed on the scheduler, so that on NUMA machines each page of texels is placed on
+  ///              the node that kernels will later process it on.
+  ///
+  /// @param allocator The allocator to allocate the texels with, including the tiles copied out of shared storage.
+  cpu_texture(const uint32_t size,
+              const texture_layout layout,
+              scheduler* sched,
+              std::shared_ptr<memory_allocator> allocator)
     : size_(size)
-      , data_(size * size, glm::vec4(0.0f, 0.0f, 0.0f, 0.0f))
+      , layout_(layout)
+      , blocks_per_axis_((size + block_size() - 1) / block_size())
+      , allocator_(std::move(allocator))
+      , data_(std::make_shared<texel_vector>(get_storage_size(size, layout), texel_allocator<glm::vec4>(allocator_)))
   {
+    for_each_band(sched, [this](const size_t offset, const size_t count) {
+      std::fill_n(&(*data_)[offset], count, glm::vec4(0.0f, 0.0f, 0.0f, 0.0f));
+    });
   }
 
-  explicit cpu_texture(const cpu_texture& other) = default;
+  /// @brief Creates a copy of the texture that shares its storage.
+  ///
+  /// @details Tiles are shared until either texture maps them for writing, at which point the writer gets a private
+  ///          copy of the tile. Copying is therefore cheap, and only the tiles that change afterwards take memory.
+  ///
+  /// @return The copy of the texture.
+  std::unique_ptr<cpu_texture> share()
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+
+    if (tiles_.empty())
+      tiles_.resize(static_cast<size_t>(get_tile_count()) * get_tile_count());
+
+    // The flag is set once the tiles exist, so that threads that see it also see the tiles.
+    shared_.store(true, std::memory_order_release);
+
+    return std::unique_ptr<cpu_texture>(new cpu_texture(*this));
+  }
 
   void read_data(float* data) override
   {
-    for (uint32_t y = 0; y < size_; y++) {
+    if ((layout_ == texture_layout::linear) && !is_shared()) {
+      std::memcpy(data, data_->data(), static_cast<size_t>(size_) * size_ * sizeof(glm::vec4));
+      return;
+    }
 
-      for (uint32_t x = 0; x < size_; x++) {
+    // Texels are gathered tile by tile, which also converts blocks back to rows.
 
-        const glm::vec4 t = data_[(y * size_) + x];
+    for (uint32_t y = 0; y < size_; y += get_tile_size()) {
 
-        const auto offset = ((y * size_) + x) * 4;
+      for (uint32_t x = 0; x < size_; x += get_tile_size()) {
 
-        data[offset + 0] = t.r;
-        data[offset + 1] = t.g;
-        data[offset + 2] = t.b;
-        data[offset + 3] = t.a;
+        const glm::uvec2 origin(x, y);
+
+        const auto extent = glm::min(glm::uvec2(get_tile_size()), glm::uvec2(size_) - origin);
+
+        const auto tile = map_region(origin, extent, tile_access::read_only);
+
+        for (uint32_t row = 0; row < extent.y; row++) {
+          std::memcpy(&data[((static_cast<size_t>(y + row) * size_) + x) * 4],
+                      &tile.data[row * tile.pitch],
+                      extent.x * sizeof(glm::vec4));
+        }
       }
     }
   }
 
   [[nodiscard]] uint32_t get_size() const override { return size_; }
 
-  void* get_data_pointer() override { return data_.data(); }
+  [[nodiscard]] texture_desc get_desc() const override
+  {
+    texture_desc desc;
+    desc.size = size_;
+    desc.layout = layout_;
+    return desc;
+  }
+
+  [[nodiscard]] uint32_t get_tile_size() const override
+  {
+    return (layout_ == texture_layout::tiled) ? block_size() : tile_size();
+  }
+
+  [[nodiscard]] size_t get_memory_usage() const override
+  {
+    size_t bytes = (data_->size() * sizeof(glm::vec4)) / static_cast<size_t>(data_.use_count());
+
+    if (!is_shared())
+      return bytes;
+
+    std::lock_guard<std::mutex> guard(lock_);
+
+    const auto tile_bytes = static_cast<size_t>(get_tile_size()) * get_tile_size() * sizeof(glm::vec4);
+
+    for (const auto& tile : tiles_) {
+      if (tile)
+        bytes += tile_bytes / static_cast<size_t>(tile.use_count());
+    }
+
+    return bytes;
+  }
+
+  texel_tile map_region(const glm::uvec2 origin, const glm::uvec2 size, const tile_access access) override
+  {
+    const auto pitch = (layout_ == texture_layout::tiled) ? block_size() : size_;
+
+    if (!is_shared())
+      return texel_tile{ &(*data_)[get_texel_offset(origin)], origin, size, pitch };
+
+    std::lock_guard<std::mutex> guard(lock_);
 
-  [[nodiscard]] const void* get_data_pointer() const override { return data_.data(); }
+    const auto tile_pos = origin / get_tile_size();
+
+    auto& tile = tiles_[(static_cast<size_t>(tile_pos.y) * get_tile_count()) + tile_pos.x];
+
+    const bool still_shared = tile ? (tile.use_count() > 1) : (data_.use_count() > 1);
+
+    if ((access != tile_access::read_only) && still_shared) {
+
+      const bool discard = (access == tile_access::write_only) && (size == get_tile_extent(origin));
+
+      // The shared texels must not be written, so a tile that can not be copied is not mapped at all.
+      auto copy = copy_tile(tile, tile_pos * get_tile_size(), discard);
+      if (!copy)
+        return texel_tile{};
+
+      tile = std::move(copy);
+    }
+
+    if (!tile)
+      return texel_tile{ &(*data_)[get_texel_offset(origin)], origin, size, pitch };
+
+    const auto offset = origin % get_tile_size();
+
+    return texel_tile{ tile.get() + (offset.y * get_tile_size()) + offset.x, origin, size, get_tile_size() };
+  }
+
+  void unmap_region(const texel_tile&, tile_access) override {}
+
+  void* get_data_pointer() override
+  {
+    return ((layout_ == texture_layout::linear) && !is_shared()) ? data_->data() : nullptr;
+  }
+
+  [[nodiscard]] const void* get_data_pointer() const override
+  {
+    return ((layout_ == texture_layout::linear) && !is_shared()) ? data_->data() : nullptr;
+  }
 
 private:
+  /// @brief The storage of a tile that has been copied out of shared storage.
+  using tile_ptr = std::shared_ptr<glm::vec4>;
+
+  cpu_texture(const cpu_texture& other)
+    : texture(other)
+      , size_(other.size_)
+      , layout_(other.layout_)
+      , blocks_per_axis_(other.blocks_per_axis_)
+      , allocator_(other.allocator_)
+      , data_(other.data_)
+      , tiles_(other.tiles_)
+      , shared_(true)
+  {
+  }
+
+  /// @brief Indicates whether the texture has ever shared its storage with a copy.
+  ///        Textures that have not take no locks when mapping tiles.
+  [[nodiscard]] bool is_shared() const { return shared_.load(std::memory_order_acquire); }
+
+  [[nodiscard]] uint32_t get_tile_count() const { return (size_ + get_tile_size() - 1) / get_tile_size(); }
+
+  /// @brief Gets the size of the part of a tile that lies within the texture.
+  [[nodiscard]] glm::uvec2 get_tile_extent(const glm::uvec2 origin) const
+  {
+    const auto tile_origin = origin - (origin % get_tile_size());
+
+    return glm::min(glm::uvec2(get_tile_size()), glm::uvec2(size_) - tile_origin);
+  }
+
+  /// @brief Copies a tile into storage private to this texture.
+  ///
+  /// @param src The private storage of the tile, or null if the tile is still in the shared storage.
+  ///
+  /// @param tile_origin The position of the first texel of the tile.
+  ///
+  /// @param discard Whether the contents of the tile are about to be overwritten, so that copying them can be skipped.
+  ///
+  /// @return The new storage of the tile, or a null pointer if it could not be allocated. Since the storage is
+  ///         allocated through the allocator of the device, it is counted in the memory of the device and checked
+  ///         against its budget, and failures are reported there.
+  tile_ptr copy_tile(const tile_ptr& src, const glm::uvec2 tile_origin, const bool discard) const
+  {
+    const auto texel_count = static_cast<size_t>(get_tile_size()) * get_tile_size();
+
+    const auto byte_count = texel_count * sizeof(glm::vec4);
+
+    auto* storage = static_cast<glm::vec4*>(allocator_->allocate(byte_count, texel_alignment));
+    if (!storage)
+      return nullptr;
+
+    // The deleter keeps the allocator alive, since the tile may be shared with copies that outlive this texture.
+    tile_ptr dst(storage, [allocator = allocator_, byte_count](glm::vec4* ptr) {
+      allocator->deallocate(ptr, byte_count);
+    });
+
+    if (discard)
+      return dst;
+
+    if (src) {
+      std::memcpy(dst.get(), src.get(), byte_count);
+      return dst;
+    }
+
+    const auto pitch = (layout_ == texture_layout::tiled) ? block_size() : size_;
+
+    const auto extent = get_tile_extent(tile_origin);
+
+    for (uint32_t row = 0; row < extent.y; row++) {
+      std::memcpy(dst.get() + (row * get_tile_size()),
+                  &(*data_)[get_texel_offset(tile_origin) + (static_cast<size_t>(row) * pitch)],
+                  extent.x * sizeof(glm::vec4));
+    }
+
+    return dst;
+  }
+
+  /// @brief Calls a function for each band of texels that a row of dispatch tiles covers.
+  ///        The bands are processed in parallel, in the same order that dispatches process tiles in.
+  void for_each_band(scheduler* sched, const std::function<void(size_t offset, size_t count)>& func)
+  {
+    if (data_->empty())
+      return;
+
+    const auto row_pitch = (layout_ == texture_layout::tiled) ? (blocks_per_axis_ * block_size()) : size_;
+
+    const auto band_size = static_cast<size_t>(get_tile_size()) * row_pitch;
+
+    const auto band_count = static_cast<uint32_t>((data_->size() + band_size - 1) / band_size);
+
+    auto process_band = [this, &func, band_size](const uint32_t band) {
+      const auto offset = band * band_size;
+      func(offset, std::min(band_size, data_->size() - offset));
+    };
+
+    if (!sched) {
+      for (uint32_t band = 0; band < band_count; band++)
+        process_band(band);
+      return;
+    }
+
+    sched->parallel_for(band_count, process_band);
+  }
+
+  static size_t get_storage_size(const uint32_t size, const texture_layout layout)
+  {
+    if (layout == texture_layout::linear)
+      return static_cast<size_t>(size) * size;
+
+    // Blocks on the right and bottom edges are padded out to the full block size.
+    const size_t padded_size = ((size + block_size() - 1) / block_size()) * block_size();
+
+    return padded_size * padded_size;
+  }
+
+  [[nodiscard]] size_t get_texel_offset(const glm::uvec2 texel) const
+  {
+    if (layout_ == texture_layout::linear)
+      return (static_cast<size_t>(texel.y) * size_) + texel.x;
+
+    const auto block = texel / block_size();
+
+    const auto block_offset = (static_cast<size_t>(block.y) * blocks_per_axis_) + block.x;
+
+    const auto local = texel % block_size();
+
+    return (block_offset * block_size() * block_size()) + (local.y * block_size()) + local.x;
+  }
+
   const uint32_t size_{ 0 };
 
-  std::vector<glm::vec4> data_;
+  const texture_layout layout_{ texture_layout::linear };
+
+  const uint32_t blocks_per_axis_{ 0 };
+
+  std::shared_ptr<memory_allocator> allocator_;
+
+  /// @brief The texels, which may be shared with copies of the texture.
+  ///        Shared texels are never written to; tiles are copied into @ref cpu_texture::tiles_ first.
+  std::shared_ptr<texel_vector> data_;
+
+  /// @brief For textures that have been copied, the private storage of each tile that has been written since.
+  ///        Tiles without private storage are read from @ref cpu_texture::data_.
+  std::vector<tile_ptr> tiles_;
+
+  /// @brief Whether the texture has ever shared its storage, after which @ref cpu_texture::tiles_ is only accessed
+  ///        under the lock. This is separate from the tiles, so that it can be checked without the lock.
+  std::atomic<bool> shared_{ false };
+
+  /// @brief Guards @ref cpu_texture::tiles_ once the texture has been copied.
+  mutable std::mutex lock_;
+};
+
+class cpu_buffer final : public buffer
+{
+public:
+  cpu_buffer(const size_t size, std::shared_ptr<memory_allocator> allocator)
+    : data_(size, 0, texel_allocator<unsigned char>(std::move(allocator)))
+  {
+  }
+
+  [[nodiscard]] size_t get_size() const override { return data_.size(); }
+
+  void* map() override { return data_.data(); }
+
+  void unmap() override {}
+
+private:
+  /// @brief The contents of the buffer. The texel allocator is used for its alignment.
+  std::vector<unsigned char, texel_allocator<unsigned char>> data_;
 };
 
 class cpu_device final : public device
 {
 public:
-  cpu_device(void* logger_data, ptg_log_callback logger_func)
-    : logger_data_(logger_data)
+  cpu_device(void* logger_data,
+             ptg_log_callback logger_func,
+             std::unique_ptr<scheduler> sched,
+             std::shared_ptr<memory_allocator> allocator)
+    : scheduler_(std::move(sched))
+      , memory_(std::make_shared<budget_allocator>(std::move(allocator)))
+      , allocator_(memory_)
+      , logger_data_(logger_data)
       , logger_func_(logger_func)
   {
+    memory_->set_callbacks([this]() { trim_page_caches(); }, [this](const std::string& msg) { report_error(msg); });
+  }
+
+  cpu_device(const cpu_device&) = delete;
+
+  cpu_device(cpu_device&&) = delete;
+
+  cpu_device& operator=(const cpu_device&) = delete;
+
+  cpu_device& operator=(cpu_device&&) = delete;
+
+  ~cpu_device() override
+  {
+    // Memory allocated through the device may be freed after it is gone (such as tiles still shared with copies
+    // held elsewhere), so the allocator must stop calling back into it.
+    memory_->set_callbacks(nullptr, nullptr);
   }
 
   uint32_t get_max_texture_size() override { return 65536; }
 
-  texture* create_texture(const uint32_t size) override
+  using device::create_texture;
+
+  texture* create_texture(const texture_desc& desc) override
   {
-    auto t = std::make_unique<cpu_texture>(size);
-    textures_.emplace_back(std::move(t));
-    return textures_.back().get();
+    const trace_scope scope(&trace_, "create texture", "texture");
+
+    if (desc.storage == texture_storage::mapped)
+      return create_mapped_texture(desc.path.c_str(), desc.size, desc.map_flags);
+
+    std::unique_ptr<texture> t;
+
+    // Storage is allocated through the allocator of the device, which checks it against the budget. A failed
+    // allocation has already been reported by the time it is thrown, so the texture is simply not created.
+    try {
+      switch (desc.storage) {
+        case texture_storage::memory:
+          if (desc.format == texel_format::rgba32f)
+            t = std::make_unique<cpu_texture>(desc.size, desc.layout, scheduler_.get(), allocator_);
+          else
+            t = std::make_unique<packed_texture>(
+              desc.size, desc.format, desc.format_scale, desc.format_offset, allocator_);
+          break;
+        case texture_storage::paged:
+          t = paged_texture::create(
+            desc.size,
+            desc.cache ? desc.cache : std::make_shared<page_cache>(default_page_budget, "", allocator_),
+            [this](const std::string& msg) { report_error(msg); });
+          break;
+        case texture_storage::sparse:
+          t = std::make_unique<sparse_texture>(desc.size, allocator_);
+          break;
+        case texture_storage::mapped:
+          break;
+        case texture_storage::compressed:
+          t = std::make_unique<compressed_texture>(desc.size, desc.max_error, allocator_);
+          break;
+      }
+    } catch (const std::bad_alloc&) {
+      return nullptr;
+    }
+
+    if (!t) {
+      error("Failed to create texture storage.");
+      return nullptr;
+    }
+
+    stats_.record_texture(get_texel_data_size(desc.size, desc.format));
+
+    return add_texture(std::move(t));
+  }
+
+  texture* create_mapped_texture(const char* path, const uint32_t size, const uint32_t flags) override
+  {
+    const trace_scope scope(&trace_, "create mapped texture", "texture");
+
+    auto t = mapped_texture::create(path, size, flags);
+    if (!t) {
+      error("Failed to create memory-mapped texture file.");
+      return nullptr;
+    }
+
+    stats_.record_texture(get_texel_data_size(size, texel_format::rgba32f));
+
+    return add_texture(std::move(t));
   }
 
   void destroy_texture(texture* t) override
   {
+    const trace_scope scope(&trace_, "destroy texture", "texture");
+
+    // The texture is released after the lock, since releasing a texture may write it back to a file.
+    std::unique_ptr<texture> released;
+
+    std::lock_guard<std::mutex> guard(lock_);
+
     for (auto it = textures_.begin(); it != textures_.end(); ++it) {
       if (it->get() == t) {
+        released = std::move(*it);
         textures_.erase(it);
         return;
       }
@@ -83,13 +485,87 @@ public:
 
   texture* copy_texture(texture* src) override
   {
-    auto tmp = std::make_unique<cpu_texture>(*dynamic_cast<cpu_texture*>(src));
+    const trace_scope scope(&trace_, "copy texture", "texture");
 
-    const auto ptr = tmp.get();
+    if (auto* src_texture = dynamic_cast<cpu_texture*>(src)) {
 
-    textures_.emplace_back(std::move(tmp));
+      // The copy shares the texels of the source, so it holds no memory of its own until it is written.
+      return add_texture(src_texture->share());
+    }
 
-    return ptr;
+    // Other kinds of textures are copied one tile at a time, since they may not fit in memory.
+
+    auto* dst = create_texture(src->get_desc());
+    if (!dst)
+      return nullptr;
+
+    const auto size = src->get_size();
+
+    const auto tile_size = src->get_tile_size();
+
+    for (uint32_t y = 0; y < size; y += tile_size) {
+
+      for (uint32_t x = 0; x < size; x += tile_size) {
+
+        const glm::uvec2 origin(x, y);
+
+        const auto extent = glm::min(glm::uvec2(tile_size), glm::uvec2(size) - origin);
+
+        glm::vec4 value;
+
+        if (src->is_constant(origin, extent, &value)) {
+          dst->fill_region(origin, extent, value);
+          continue;
+        }
+
+        const scratch_arena::scope scratch_scope(scratch_arena::get_thread_arena());
+
+        const auto src_tile = src->map_region(origin, extent, tile_access::read_only);
+
+        const auto dst_tile = dst->map_region(origin, extent, tile_access::write_only);
+
+        for (uint32_t row = 0; src_tile.data && dst_tile.data && (row < extent.y); row++) {
+          std::memcpy(&dst_tile.data[row * dst_tile.pitch],
+                      &src_tile.data[row * src_tile.pitch],
+                      extent.x * sizeof(glm::vec4));
+        }
+
+        dst->unmap_region(dst_tile, tile_access::write_only);
+
+        src->unmap_region(src_tile, tile_access::read_only);
+      }
+    }
+
+    return dst;
+  }
+
+  buffer* create_buffer(const size_t size) override
+  {
+    std::unique_ptr<buffer> b;
+
+    try {
+      b = std::make_unique<cpu_buffer>(size, allocator_);
+    } catch (const std::bad_alloc&) {
+      return nullptr;
+    }
+
+    std::lock_guard<std::mutex> guard(lock_);
+
+    buffers_.emplace_back(std::move(b));
+
+    return buffers_.back().get();
+  }
+
+  void destroy_buffer(buffer* b) override
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+
+    for (auto it = buffers_.begin(); it != buffers_.end(); ++it) {
+      if (it->get() == b) {
+        buffers_.erase(it);
+        return;
+      }
+    }
   }
 
   const kernel_registry* get_kernel_registry() override
@@ -97,6 +573,18 @@ public:
     return &kernel_registry_;
   }
 
+  device_stats* get_stats() override { return &stats_; }
+
+  const memory_stats* get_memory_stats() override { return &memory_->get_stats(); }
+
+  void set_memory_budget(const size_t budget) override { memory_->set_budget(budget); }
+
+  trace_recorder* get_trace() override { return &trace_; }
+
+  const std::shared_ptr<memory_allocator>& get_allocator() override { return allocator_; }
+
+  scheduler* get_scheduler() override { return scheduler_.get(); }
+
   glm::uvec2 get_work_group_size() override
   {
     return cpu_kernel::work_group_size();
@@ -104,30 +592,175 @@ public:
 
   void log(PtgSeverity severity, const char* msg) override
   {
-    if (logger_func_)
+    if (!is_log_enabled(severity))
+      return;
+
+    if (log_queue_)
+      log_queue_->push(severity, msg);
+    else
       logger_func_(logger_data_, severity, msg);
   }
 
+  [[nodiscard]] bool is_log_enabled(const PtgSeverity severity) const override
+  {
+    return logger_func_ && (severity >= log_level_.load(std::memory_order_relaxed));
+  }
+
+  void set_log_level(const PtgSeverity level) override { log_level_ = level; }
+
+  void set_log_mode(const PtgLogMode mode, const uint32_t queue_capacity) override
+  {
+    // Records queued under the previous mode are passed on as the old queue is destroyed.
+    log_queue_.reset();
+
+    if ((mode == PTG_LOG_IMMEDIATE) || !logger_func_)
+      return;
+
+    log_queue_ = std::make_unique<log_queue>(queue_capacity ? queue_capacity : default_log_queue_capacity,
+                                             logger_data_,
+                                             logger_func_);
+
+    if (mode == PTG_LOG_BACKGROUND)
+      log_queue_->start_thread(log_thread_interval);
+  }
+
+  void flush_log() override
+  {
+    if (log_queue_)
+      log_queue_->drain();
+  }
+
 private:
-  std::vector<std::unique_ptr<cpu_texture>> textures_;
+  /// @brief The number of log records that can be queued, when the host does not choose.
+  static constexpr uint32_t default_log_queue_capacity = 1024;
+
+  /// @brief How often the background log thread drains the log queue.
+  static constexpr std::chrono::milliseconds log_thread_interval{ 10 };
+
+  /// @brief The number of bytes a paged texture keeps in memory when it is not given a cache to share.
+  static constexpr size_t default_page_budget = 64 * 1024 * 1024;
+
+  /// @brief Gets the number of bytes of texel data in a texture, before any compression or paging.
+  static uint64_t get_texel_data_size(const uint32_t size, const texel_format format)
+  {
+    const uint64_t texel_size = (format == texel_format::rgba32f) ? sizeof(glm::vec4) : (4 * sizeof(uint16_t));
 
-  raise_kernel raise_kernel_;
+    return static_cast<uint64_t>(size) * size * texel_size;
+  }
+
+  /// @brief Takes ownership of a new texture.
+  ///
+  /// @param t The texture to take ownership of.
+  ///
+  /// @return A pointer to the texture.
+  texture* add_texture(std::unique_ptr<texture> t)
+  {
+    auto* ptr = t.get();
 
-  render_kernel render_kernel_;
+    std::lock_guard<std::mutex> guard(lock_);
 
-  const kernel_registry kernel_registry_{ &raise_kernel_, &render_kernel_ };
+    textures_.emplace_back(std::move(t));
+
+    return ptr;
+  }
+
+  /// @brief Logs an error raised by a texture or allocation, which may happen on any thread.
+  void report_error(const std::string& msg)
+  {
+    if (is_log_enabled(PTG_ERROR))
+      error(msg.c_str());
+  }
+
+  /// @brief Releases the tiles that the page caches of paged textures keep in memory, to make room for an
+  ///        allocation that does not fit in the memory budget.
+  void trim_page_caches()
+  {
+    std::vector<std::shared_ptr<page_cache>> caches;
+
+    {
+      std::lock_guard<std::mutex> guard(lock_);
+
+      for (const auto& t : textures_) {
+        const auto* paged = dynamic_cast<const paged_texture*>(t.get());
+        if (paged && (std::find(caches.begin(), caches.end(), paged->get_cache()) == caches.end()))
+          caches.emplace_back(paged->get_cache());
+      }
+    }
+
+    // Trimming writes tiles back to their files, so it is done outside of the lock.
+    for (const auto& cache : caches)
+      cache->trim();
+  }
+
+  /// @brief Makes a factory for instances of a kernel, which are dispatched on the scheduler of the device.
+  ///
+  /// @param counters The statistics that dispatches of the kernel are counted in.
+  template<typename kernel_type>
+  kernel_registry::factory make_kernel_factory(kernel_stats* counters)
+  {
+    return [this, counters]() -> std::unique_ptr<kernel> {
+      auto k = std::make_unique<kernel_type>();
+      k->set_scheduler(scheduler_.get());
+      k->set_stats(&stats_, counters);
+      k->set_trace(&trace_);
+      return k;
+    };
+  }
+
+  /// @brief Guards the lists of textures and buffers, which may be changed from several threads at once.
+  std::mutex lock_;
+
+  std::vector<std::unique_ptr<texture>> textures_;
+
+  std::vector<std::unique_ptr<buffer>> buffers_;
+
+  /// @brief Runs the parallel work of the device, which is either a pool of its own or the job system of the host.
+  std::unique_ptr<scheduler> scheduler_;
+
+  /// @brief Counts the memory held by the device and keeps it within the memory budget. Everything the device
+  ///        allocates goes through it, on top of the allocator of the host or the default allocator.
+  std::shared_ptr<budget_allocator> memory_;
+
+  /// @brief The same allocator as @ref cpu_device::memory_, as it is handed out to textures and models.
+  std::shared_ptr<memory_allocator> allocator_;
+
+  device_stats stats_;
+
+  trace_recorder trace_;
+
+  const kernel_registry kernel_registry_{ make_kernel_factory<raise_kernel>(&stats_.raise_kernel),
+                                          make_kernel_factory<render_kernel>(&stats_.render_kernel) };
 
   void* logger_data_{ nullptr };
 
   ptg_log_callback logger_func_{ nullptr };
+
+  /// @brief The lowest severity of the records that are logged.
+  std::atomic<PtgSeverity> log_level_{ PTG_INFO };
+
+  /// @brief If records are logged asynchronously, the queue they are pushed into.
+  ///        This is declared last, so that it is destroyed (passing on the remaining records) first.
+  std::unique_ptr<log_queue> log_queue_;
 };
 
 } // namespace
 
 std::shared_ptr<device>
-create_cpu_device(void* logger_data, ptg_log_callback logger_func)
+create_cpu_device(void* logger_data,
+                  ptg_log_callback logger_func,
+                  const PtgScheduler* scheduler,
+                  const PtgAllocator* allocator)
 {
-  return std::make_shared<cpu_device>(logger_data, logger_func);
+  std::unique_ptr<ptg::scheduler> sched;
+
+  if (scheduler)
+    sched = std::make_unique<host_scheduler>(*scheduler);
+  else
+    sched = std::make_unique<thread_pool>();
+
+  auto alloc = allocator ? std::make_shared<host_allocator>(*allocator) : get_default_allocator();
+
+  return std::make_shared<cpu_device>(logger_data, logger_func, std::move(sched), std::move(alloc));
 }
 
 } // namespace ptg
@@ -8,7 +8,23 @@
 
 namespace ptg {
 
+/// @brief Creates a device that runs kernels on the CPU.
+///
+/// @param logger_data An optional pointer to pass to the logger function.
+///
+/// @param logger_func An optional function to pass log records to.
+///
+/// @param scheduler If not null, the job system to run parallel work on. Otherwise, the device starts a pool of
+///                  worker threads of its own.
+///
+/// @param allocator If not null, the allocator to allocate texel storage, buffers and model data with. Otherwise, the
+///                  device uses the default allocator.
+///
+/// @return The new device.
 std::shared_ptr<device>
-create_cpu_device(void* logger_data, ptg_log_callback logger_func);
+create_cpu_device(void* logger_data,
+                  ptg_log_callback logger_func,
+                  const PtgScheduler* scheduler = nullptr,
+                  const PtgAllocator* allocator = nullptr);
 
 } // namespace ptg
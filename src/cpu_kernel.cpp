@@ -1,5 +1,15 @@
 #include "cpu_kernel.hpp"
 
+#include "device_stats.hpp"
+#include "perf_counters.hpp"
+#include "scheduler.hpp"
+#include "trace.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+
 namespace ptg {
 
 void
@@ -8,6 +18,13 @@ cpu_kernel::set_active_texture(const int texture_index, texture* t)
   active_textures_.at(texture_index) = t;
 }
 
+void
+cpu_kernel::set_buffer(const int buffer_index, buffer* b)
+{
+  if ((buffer_index >= 0) && (buffer_index < max_buffers()))
+    active_buffers_[buffer_index] = b;
+}
+
 void
 cpu_kernel::register_uniform(const char* name, void* ptr)
 {
@@ -18,6 +35,27 @@ cpu_kernel::register_uniform(const char* name, void* ptr)
   uniform_locations_.emplace(name, location);
 }
 
+void
+cpu_kernel::register_param_block(void* block, const size_t size, const param_block_type type)
+{
+  param_block_ = block;
+
+  param_block_size_ = size;
+
+  param_block_type_ = type;
+}
+
+bool
+cpu_kernel::set_param_block(const void* params, const size_t size, const param_block_type type)
+{
+  if (!param_block_ || (size != param_block_size_) || (type != param_block_type_))
+    return false;
+
+  std::memcpy(param_block_, params, size);
+
+  return true;
+}
+
 int
 cpu_kernel::get_uniform_location(const char* name)
 {
@@ -29,13 +67,201 @@ cpu_kernel::get_uniform_location(const char* name)
 }
 
 void
-cpu_kernel::dispatch(const glm::uvec2 work_group_count)
+cpu_kernel::begin_dispatch(const glm::uvec2)
 {
-  for (uint32_t y = 0; y < work_group_count.y; y++) {
-    for (uint32_t x = 0; x < work_group_count.x; x++) {
-      local_dispatch({ x, y }, work_group_count);
+}
+
+void
+cpu_kernel::end_dispatch()
+{
+}
+
+scratch_arena&
+cpu_kernel::get_scratch_arena()
+{
+  return scratch_arena::get_thread_arena();
+}
+
+void
+cpu_kernel::process_tile(const glm::uvec2 origin,
+                         const glm::uvec2 extent,
+                         const glm::uvec2 work_group_count,
+                         const texel_tile* tiles)
+{
+  const auto wg_min = origin / work_group_size();
+
+  const auto wg_max = (origin + extent) / work_group_size();
+
+  for (uint32_t y = wg_min.y; y < wg_max.y; y++) {
+    for (uint32_t x = wg_min.x; x < wg_max.x; x++) {
+      local_dispatch({ x, y }, work_group_count, tiles);
     }
   }
 }
 
+tile_access
+cpu_kernel::get_texture_access(const int) const
+{
+  return tile_access::read_write;
+}
+
+bool
+cpu_kernel::skip_region(const glm::uvec2, const glm::uvec2)
+{
+  return false;
+}
+
+void
+cpu_kernel::dispatch(const glm::uvec2 work_group_origin,
+                     const glm::uvec2 work_group_count,
+                     const glm::uvec2 work_group_bounds)
+{
+  // The dispatch is split into tiles that each lie within a single storage tile of every bound texture.
+  // Tiles are processed in row-major order, which matches the order that tiled textures are stored in.
+  // The tile grid is anchored at the first texel of the textures rather than at the start of the region, and its
+  // step is the smallest storage tile size of the bound textures, which the other tile sizes are multiples of. The
+  // cells of the grid are then clipped to the region, so that tiles never cross the border of a storage tile.
+
+  const auto wg_end = glm::min(work_group_origin + work_group_count, work_group_bounds);
+
+  if ((work_group_origin.x >= wg_end.x) || (work_group_origin.y >= wg_end.y))
+    return;
+
+  const trace_scope dispatch_scope(trace_, get_name(), "dispatch");
+
+  // The clock is only read when statistics are enabled.
+  const bool collect_stats = kernel_stats_ && device_stats_ && device_stats_->is_enabled();
+
+  const auto start_time = collect_stats ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+
+  std::atomic<uint64_t> texel_count{ 0 };
+
+  // Hardware counters are read on the thread that processes each tile, since they only count the calling thread.
+  const bool collect_events = collect_stats && device_stats_->is_perf_enabled();
+
+  const auto region_min = work_group_origin * work_group_size();
+
+  const auto region_max = wg_end * work_group_size();
+
+  // Without textures there are no storage tiles to stay within, so the whole region is a single tile.
+  uint32_t tile_size = region_max.x > region_max.y ? region_max.x : region_max.y;
+
+  bool has_textures = false;
+
+  for (const auto* t : active_textures_) {
+    if (t && (!has_textures || (t->get_tile_size() < tile_size))) {
+      tile_size = t->get_tile_size();
+      has_textures = true;
+    }
+  }
+
+  tile_size = (tile_size < work_group_size().x) ? work_group_size().x : tile_size;
+
+  const auto first_tile = region_min / tile_size;
+
+  const glm::uvec2 tile_count = ((region_max + glm::uvec2(tile_size - 1)) / tile_size) - first_tile;
+
+  auto dispatch_tile = [this,
+                        work_group_bounds,
+                        region_min,
+                        region_max,
+                        tile_size,
+                        first_tile,
+                        tile_count,
+                        collect_stats,
+                        collect_events,
+                        &texel_count](const uint32_t tile_index) {
+    const auto tile_pos = first_tile + glm::uvec2(tile_index % tile_count.x, tile_index / tile_count.x);
+
+    const auto origin = glm::max(tile_pos * tile_size, region_min);
+
+    const auto extent = glm::min((tile_pos + glm::uvec2(1, 1)) * tile_size, region_max) - origin;
+
+    if (skip_region(origin, extent))
+      return;
+
+    // Tiles are traced on the thread that processes them, which shows how busy each worker is.
+    const trace_scope tile_scope(trace_, get_name(), "tile");
+
+    // This also releases the texels that textures decode into when the tile is mapped.
+    const scratch_arena::scope scratch_scope(get_scratch_arena());
+
+    texel_tile tiles[max_textures()];
+
+    bool mapped = true;
+
+    for (int i = 0; i < max_textures(); i++) {
+      if (active_textures_[i]) {
+        assert(origin / active_textures_[i]->get_tile_size() ==
+               (origin + extent - glm::uvec2(1, 1)) / active_textures_[i]->get_tile_size());
+        tiles[i] = active_textures_[i]->map_region(origin, extent, get_texture_access(i));
+        mapped = mapped && tiles[i].data;
+      }
+    }
+
+    // A texture that could not map the tile has already reported why, and the tile is skipped.
+    if (!mapped) {
+      for (int i = 0; i < max_textures(); i++) {
+        if (active_textures_[i])
+          active_textures_[i]->unmap_region(tiles[i], get_texture_access(i));
+      }
+      return;
+    }
+
+    perf_sample events_before;
+
+    const bool count_events = collect_events && perf_counters::get_thread_counters().read(&events_before);
+
+    process_tile(origin, extent, work_group_bounds, tiles);
+
+    perf_sample events_after;
+
+    if (count_events && perf_counters::get_thread_counters().read(&events_after)) {
+      kernel_stats_->record_events(perf_sample{ events_after.cycles - events_before.cycles,
+                                                events_after.instructions - events_before.instructions,
+                                                events_after.llc_misses - events_before.llc_misses,
+                                                events_after.dtlb_misses - events_before.dtlb_misses });
+    }
+
+    if (collect_stats)
+      texel_count.fetch_add(static_cast<uint64_t>(extent.x) * extent.y, std::memory_order_relaxed);
+
+    for (int i = 0; i < max_textures(); i++) {
+      if (active_textures_[i])
+        active_textures_[i]->unmap_region(tiles[i], get_texture_access(i));
+    }
+  };
+
+  const auto total_tiles = tile_count.x * tile_count.y;
+
+  for (int i = 0; i < max_buffers(); i++) {
+    if (active_buffers_[i])
+      mapped_buffers_[i] = mapped_buffer{ active_buffers_[i]->map(), active_buffers_[i]->get_size() };
+  }
+
+  begin_dispatch(work_group_bounds);
+
+  if (!scheduler_) {
+    for (uint32_t i = 0; i < total_tiles; i++)
+      dispatch_tile(i);
+  } else {
+    // Work groups write to disjoint texels, so tiles can be processed in parallel.
+    scheduler_->parallel_for(total_tiles, dispatch_tile);
+  }
+
+  end_dispatch();
+
+  for (int i = 0; i < max_buffers(); i++) {
+    if (active_buffers_[i])
+      active_buffers_[i]->unmap();
+    mapped_buffers_[i] = mapped_buffer{};
+  }
+
+  if (collect_stats) {
+    const auto elapsed = std::chrono::steady_clock::now() - start_time;
+    const auto elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    kernel_stats_->record_dispatch(static_cast<uint64_t>(elapsed_ns), texel_count.load());
+  }
+}
+
 } // namespace ptg
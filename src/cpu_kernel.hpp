@@ -4,7 +4,10 @@
 
 #pragma once
 
+#include "buffer.hpp"
 #include "kernel.hpp"
+#include "scratch_arena.hpp"
+#include "texture.hpp"
 
 #include <vector>
 #include <map>
@@ -12,12 +15,23 @@
 
 namespace ptg {
 
+class scheduler;
+struct device_stats;
+struct kernel_stats;
+class trace_recorder;
+
 /// This is a base class for a CPU kernel.
 class cpu_kernel : public kernel
 {
 public:
   static constexpr glm::uvec2 work_group_size() { return { 4u, 4u }; };
 
+  /// @brief The maximum number of textures that can be bound to a kernel.
+  static constexpr int max_textures() { return 4; }
+
+  /// @brief The maximum number of buffers that can be bound to a kernel.
+  static constexpr int max_buffers() { return 4; }
+
   cpu_kernel() = default;
 
   cpu_kernel(const cpu_kernel&) = default;
@@ -30,14 +44,121 @@ public:
 
   ~cpu_kernel() override = default;
 
-  void dispatch(glm::uvec2 work_group_count) override;
+  using kernel::dispatch;
+
+  void dispatch(glm::uvec2 work_group_origin, glm::uvec2 work_group_count, glm::uvec2 work_group_bounds) override;
+
+  /// @brief Sets the scheduler that work groups are distributed across.
+  ///
+  /// @param sched The scheduler to use. If this is null, work groups are processed on the calling thread.
+  void set_scheduler(scheduler* sched) { scheduler_ = sched; }
+
+  /// @brief Sets where the dispatches of the kernel are counted.
+  ///
+  /// @param stats The statistics of the device, which decide whether dispatches are counted.
+  ///
+  /// @param counters The counters that dispatches of this kernel are added to.
+  void set_stats(const device_stats* stats, kernel_stats* counters)
+  {
+    device_stats_ = stats;
+    kernel_stats_ = counters;
+  }
 
-  virtual void local_dispatch(glm::uvec2 work_group_id, glm::uvec2 work_group_count) = 0;
+  /// @brief Sets the recorder that dispatches of the kernel are traced with.
+  ///
+  /// @param trace The trace recorder, or a null pointer to not trace dispatches.
+  void set_trace(trace_recorder* trace) { trace_ = trace; }
+
+  /// @brief Gets the name of the kernel, which dispatches are labelled with in traces.
+  ///
+  /// @return The name of the kernel, which is a string literal.
+  [[nodiscard]] virtual const char* get_name() const = 0;
+
+  /// @brief Called once at the start of each dispatch, before any tile is processed.
+  ///        Kernels use this to compute values that are the same for every work group, such as matrices.
+  ///        Bound buffers are already mapped when this is called.
+  ///
+  /// @param work_group_count The total number of work groups in the dispatch.
+  virtual void begin_dispatch(glm::uvec2 work_group_count);
+
+  /// @brief Called once at the end of each dispatch, after every tile has been processed.
+  virtual void end_dispatch();
+
+  /// @brief Gets the scratch arena of the calling thread, which is @ref scratch_arena::get_thread_arena.
+  ///        Memory allocated from it while processing a tile is released once the tile is done, so kernels can use
+  ///        it for temporary arrays and accumulators without going through the heap.
+  ///
+  /// @return The scratch arena of the calling thread.
+  static scratch_arena& get_scratch_arena();
+
+  /// @brief Processes a single work group.
+  ///
+  /// @param work_group_id The position of the work group being processed.
+  ///
+  /// @param work_group_count The total number of work groups in the dispatch.
+  ///
+  /// @param tiles The mapped texels of each bound texture, indexed by texture unit.
+  ///              Each one covers at least the texels of this work group, and is addressed by texture position.
+  virtual void local_dispatch(glm::uvec2 work_group_id, glm::uvec2 work_group_count, const texel_tile* tiles) = 0;
+
+  /// @brief Processes every work group within a tile.
+  ///        The default calls @ref cpu_kernel::local_dispatch for each work group. Kernels derived from
+  ///        @ref cpu_kernel_base replace this with a loop that is inlined into the kernel.
+  ///
+  /// @param origin The position of the first texel of the tile. This is a multiple of the work group size.
+  ///
+  /// @param extent The number of texels in each axis of the tile. This is a multiple of the work group size.
+  ///
+  /// @param work_group_count The total number of work groups in the dispatch.
+  ///
+  /// @param tiles The mapped texels of each bound texture, indexed by texture unit.
+  virtual void process_tile(glm::uvec2 origin, glm::uvec2 extent, glm::uvec2 work_group_count, const texel_tile* tiles);
+
+  /// @brief Indicates how the kernel accesses a bound texture.
+  ///        Kernels that fully overwrite a texture should report it as write only, so that its previous contents do
+  ///        not need to be loaded.
+  ///
+  /// @param texture_index The texture unit to get the access of.
+  ///
+  /// @return How the texture bound to the given unit is accessed.
+  [[nodiscard]] virtual tile_access get_texture_access(int texture_index) const;
+
+  /// @brief Gives the kernel a chance to handle a tile without mapping its texels.
+  ///        Kernels can use this to avoid touching regions they leave unchanged, which keeps sparse textures sparse.
+  ///
+  /// @param origin The position of the first texel of the tile.
+  ///
+  /// @param extent The number of texels in each axis of the tile.
+  ///
+  /// @return True if the tile was handled and should not be processed, false otherwise.
+  virtual bool skip_region(glm::uvec2 origin, glm::uvec2 extent);
 
   void register_uniform(const char* name, void* ptr);
 
+  /// @brief Registers the parameter block of the kernel, which @ref cpu_kernel::set_param_block copies into.
+  ///
+  /// @param block The parameter block, which is usually a member of the derived kernel.
+  template<typename params_type>
+  void register_params(params_type& block)
+  {
+    register_param_block(&block, sizeof(block), params_type::type);
+  }
+
+  /// @brief Registers the parameter block of the kernel. Prefer calling @ref cpu_kernel::register_params.
+  ///
+  /// @param block A pointer to the parameter block.
+  ///
+  /// @param size The size of the parameter block, in bytes.
+  ///
+  /// @param type The type of the parameter block.
+  void register_param_block(void* block, size_t size, param_block_type type);
+
   void set_active_texture(int texture_index, texture*) override;
 
+  void set_buffer(int buffer_index, buffer* b) override;
+
+  bool set_param_block(const void* params, size_t size, param_block_type type) override;
+
   int get_uniform_location(const char* name) override;
 
   void set_uniform_uint(const int location, const unsigned int value) override
@@ -105,6 +226,22 @@ protected:
 
   [[nodiscard]] const texture* get_texture(const int texture_index) const { return active_textures_[texture_index]; }
 
+  /// @brief Gets the contents of a bound buffer during a dispatch.
+  ///
+  /// @param buffer_index The buffer unit to get the contents of.
+  ///
+  /// @return The elements of the buffer, or an empty span if no buffer is bound to the unit.
+  template<typename T>
+  [[nodiscard]] buffer_span<const T> get_buffer(const int buffer_index) const
+  {
+    if ((buffer_index < 0) || (buffer_index >= max_buffers()))
+      return buffer_span<const T>{};
+
+    const auto& mapped = mapped_buffers_[buffer_index];
+
+    return buffer_span<const T>{ static_cast<const T*>(mapped.data), mapped.size / sizeof(T) };
+  }
+
 private:
   template<typename T>
   void set_generic_uniform(const int location, const T value)
@@ -115,11 +252,117 @@ private:
   }
 
 private:
+  scheduler* scheduler_{ nullptr };
+
+  const device_stats* device_stats_{ nullptr };
+
+  kernel_stats* kernel_stats_{ nullptr };
+
+  trace_recorder* trace_{ nullptr };
+
+  void* param_block_{ nullptr };
+
+  size_t param_block_size_{ 0 };
+
+  param_block_type param_block_type_{ param_block_type::raise };
+
   std::map<std::string, int> uniform_locations_;
 
   std::vector<void*> uniform_pointers_;
 
-  std::vector<texture*> active_textures_{ static_cast<std::vector<texture*>::size_type>(4), nullptr };
+  std::vector<texture*> active_textures_{ static_cast<std::vector<texture*>::size_type>(max_textures()), nullptr };
+
+  std::vector<buffer*> active_buffers_{ static_cast<std::vector<buffer*>::size_type>(max_buffers()), nullptr };
+
+  /// @brief The contents of a bound buffer, which are mapped for the duration of a dispatch.
+  struct mapped_buffer final
+  {
+    const void* data{ nullptr };
+
+    size_t size{ 0 };
+  };
+
+  std::vector<mapped_buffer> mapped_buffers_{ static_cast<std::vector<mapped_buffer>::size_type>(max_buffers()) };
+};
+
+/// @brief A base class for CPU kernels that processes whole tiles without a virtual call per work group.
+///
+/// @details The derived kernel provides two functions, which are called without virtual dispatch so that they can be
+///          inlined:
+///
+///          - `begin_tile(work_group_count, tiles)` returns any state needed to process the texels of a tile.
+///          - `process_texel(state, texel)` processes a single texel.
+///
+///          Tiles are processed in blocks whose size is known at compile time, so that the compiler can unroll and
+///          vectorize the loop over a block. Each kernel picks the block size that suits its access pattern.
+///
+/// @tparam derived The kernel deriving from this class.
+///
+/// @tparam block_width The number of texels in each row of a block. This must divide the storage tile sizes.
+///
+/// @tparam block_height The number of rows in a block. This must divide the storage tile sizes.
+template<typename derived, uint32_t block_width, uint32_t block_height>
+class cpu_kernel_base : public cpu_kernel
+{
+public:
+  /// @brief The size of the blocks that tiles are processed in.
+  static constexpr glm::uvec2 block_size() { return { block_width, block_height }; }
+
+  void local_dispatch(const glm::uvec2 work_group_id, const glm::uvec2 work_group_count, const texel_tile* tiles) final
+  {
+    const auto& self = static_cast<const derived&>(*this);
+
+    const auto state = self.begin_tile(work_group_count, tiles);
+
+    process_texels(self, state, work_group_id * work_group_size(), work_group_size());
+  }
+
+  void process_tile(const glm::uvec2 origin,
+                    const glm::uvec2 extent,
+                    const glm::uvec2 work_group_count,
+                    const texel_tile* tiles) final
+  {
+    const auto& self = static_cast<const derived&>(*this);
+
+    const auto state = self.begin_tile(work_group_count, tiles);
+
+    const auto full = (extent / block_size()) * block_size();
+
+    for (uint32_t y = 0; y < full.y; y += block_height) {
+      for (uint32_t x = 0; x < full.x; x += block_width)
+        process_block(self, state, origin + glm::uvec2(x, y));
+    }
+
+    // Tiles at the edge of a dispatch may not be a whole number of blocks.
+
+    if (full.x < extent.x)
+      process_texels(self, state, origin + glm::uvec2(full.x, 0), glm::uvec2(extent.x - full.x, extent.y));
+
+    if (full.y < extent.y)
+      process_texels(self, state, origin + glm::uvec2(0, full.y), glm::uvec2(full.x, extent.y - full.y));
+  }
+
+private:
+  template<typename state_type>
+  static void process_block(const derived& self, const state_type& state, const glm::uvec2 origin)
+  {
+    for (uint32_t y = 0; y < block_height; y++) {
+      for (uint32_t x = 0; x < block_width; x++)
+        self.process_texel(state, origin + glm::uvec2(x, y));
+    }
+  }
+
+  template<typename state_type>
+  static void process_texels(const derived& self,
+                             const state_type& state,
+                             const glm::uvec2 origin,
+                             const glm::uvec2 size)
+  {
+    for (uint32_t y = 0; y < size.y; y++) {
+      for (uint32_t x = 0; x < size.x; x++)
+        self.process_texel(state, origin + glm::uvec2(x, y));
+    }
+  }
 };
 
 } // namespace ptg
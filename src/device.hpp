@@ -4,13 +4,19 @@
 
 #include <stdint.h>
 
+#include "buffer.hpp"
 #include "ptg.h"
+#include "texture.hpp"
 
 namespace ptg {
 
-class texture;
-
+struct device_stats;
 struct kernel_registry;
+struct memory_stats;
+
+class memory_allocator;
+class scheduler;
+class trace_recorder;
 
 class device
 {
@@ -34,10 +40,35 @@ public:
 
   /// @brief Creates a new texture.
   ///
+  /// @param desc Describes the texture to create.
+  ///
+  /// @return A new texture instance, or a null pointer if the texture could not be created.
+  virtual texture* create_texture(const texture_desc& desc) = 0;
+
+  /// @brief Creates a new texture, stored in memory.
+  ///
   /// @param texture_size The size of the texture being made.
   ///
   /// @return A new texture instance.
-  virtual texture* create_texture(uint32_t texture_size) = 0;
+  texture* create_texture(const uint32_t texture_size)
+  {
+    texture_desc desc;
+    desc.size = texture_size;
+    return create_texture(desc);
+  }
+
+  /// @brief Creates a new texture that is stored in a memory-mapped file.
+  ///        The texture is written to in place, so the file holds the current texels at all times and can be mapped
+  ///        read only by other processes.
+  ///
+  /// @param path The path of the file to create. If a file already exists at this path, it is replaced.
+  ///
+  /// @param size The size of the texture, in both axes.
+  ///
+  /// @param flags A combination of @ref map_flags.
+  ///
+  /// @return A new texture instance, or a null pointer if the file could not be created.
+  virtual texture* create_mapped_texture(const char* path, uint32_t size, uint32_t flags) = 0;
 
   /// @brief Releases memory allocated by a texture.
   ///
@@ -51,18 +82,89 @@ public:
   /// @return A pointer to the copied texture.
   virtual texture* copy_texture(texture* src) = 0;
 
+  /// @brief Creates a new buffer, for passing variable-length data to kernels.
+  ///
+  /// @param size The size of the buffer, in bytes. The contents start out as zero.
+  ///
+  /// @return A new buffer instance, or a null pointer if the buffer could not be created.
+  virtual buffer* create_buffer(size_t size) = 0;
+
+  /// @brief Releases memory allocated by a buffer.
+  ///
+  /// @param b The buffer to release the memory of.
+  virtual void destroy_buffer(buffer* b) = 0;
+
   /// @brief Gets the kernel registry for the device.
   ///
   /// @return A pointer to the kernel registry for the device.
   virtual const kernel_registry* get_kernel_registry() = 0;
 
+  /// @brief Gets the statistics collected by the device.
+  ///
+  /// @return The statistics of the device.
+  virtual device_stats* get_stats() = 0;
+
+  /// @brief Gets the memory held by the textures and buffers of the device.
+  ///        The counters are kept up to date by every allocation the device makes.
+  ///
+  /// @return The memory counters of the device.
+  virtual const memory_stats* get_memory_stats() = 0;
+
+  /// @brief Limits the memory that the textures and buffers of the device may hold.
+  ///        Every allocation made through the allocator of the device is checked. When one would exceed the budget,
+  ///        the device first releases the tiles that page caches hold in memory. If that does not make enough room,
+  ///        an error is logged and the allocation fails.
+  ///
+  /// @param budget The largest number of bytes to hold, or zero for no limit.
+  virtual void set_memory_budget(size_t budget) = 0;
+
+  /// @brief Gets the recorder that the work of the device is traced with.
+  ///
+  /// @return The trace recorder of the device.
+  virtual trace_recorder* get_trace() = 0;
+
+  /// @brief Gets the allocator that the device allocates texel storage, buffers and model data with.
+  ///
+  /// @return The allocator of the device.
+  virtual const std::shared_ptr<memory_allocator>& get_allocator() = 0;
+
+  /// @brief Gets the scheduler that the device runs parallel work on.
+  ///
+  /// @return The scheduler of the device, or a null pointer if the device runs its work on the calling thread.
+  virtual scheduler* get_scheduler() = 0;
+
   /// @brief Gets the size of a work group.
   ///
   /// @return The size of the work group for this device.
   virtual glm::uvec2 get_work_group_size() = 0;
 
+  /// @brief Passes a log record to the logger function, or queues it if the device logs asynchronously.
+  ///        Records below the log level are discarded.
   virtual void log(PtgSeverity severity, const char* msg) = 0;
 
+  /// @brief Checks whether a record of a given severity would be logged, so that formatting the message can be
+  ///        skipped when it would not.
+  ///
+  /// @param severity The severity of the record.
+  ///
+  /// @return True if the record would be passed to the logger function.
+  [[nodiscard]] virtual bool is_log_enabled(PtgSeverity severity) const = 0;
+
+  /// @brief Sets the lowest severity of the records that are logged.
+  virtual void set_log_level(PtgSeverity level) = 0;
+
+  /// @brief Changes how records are passed to the logger function.
+  ///        This must not be called while the device is in use by other threads.
+  ///
+  /// @param mode How records are passed to the logger function.
+  ///
+  /// @param queue_capacity For the queued modes, the number of records that can be queued.
+  virtual void set_log_mode(PtgLogMode mode, uint32_t queue_capacity) = 0;
+
+  /// @brief Passes the queued log records to the logger function, on the calling thread.
+  ///        This does nothing if records are not queued.
+  virtual void flush_log() = 0;
+
   void info(const char* msg) { log(PTG_INFO, msg); }
 
   void warn(const char* msg) { log(PTG_WARN, msg); }
@@ -0,0 +1,113 @@
+#include "device_stats.hpp"
+
+#include "perf_counters.hpp"
+
+namespace ptg {
+
+void
+kernel_stats::record_dispatch(const uint64_t time, const uint64_t texels)
+{
+  dispatch_count.fetch_add(1, std::memory_order_relaxed);
+
+  total_time.fetch_add(time, std::memory_order_relaxed);
+
+  texel_count.fetch_add(texels, std::memory_order_relaxed);
+
+  auto current_min = min_time.load(std::memory_order_relaxed);
+
+  while ((time < current_min) && !min_time.compare_exchange_weak(current_min, time, std::memory_order_relaxed)) {
+  }
+
+  auto current_max = max_time.load(std::memory_order_relaxed);
+
+  while ((time > current_max) && !max_time.compare_exchange_weak(current_max, time, std::memory_order_relaxed)) {
+  }
+}
+
+void
+kernel_stats::record_events(const perf_sample& events)
+{
+  cycles.fetch_add(events.cycles, std::memory_order_relaxed);
+  instructions.fetch_add(events.instructions, std::memory_order_relaxed);
+  llc_misses.fetch_add(events.llc_misses, std::memory_order_relaxed);
+  dtlb_misses.fetch_add(events.dtlb_misses, std::memory_order_relaxed);
+}
+
+void
+kernel_stats::reset()
+{
+  dispatch_count = 0;
+  total_time = 0;
+  min_time = UINT64_MAX;
+  max_time = 0;
+  texel_count = 0;
+  cycles = 0;
+  instructions = 0;
+  llc_misses = 0;
+  dtlb_misses = 0;
+}
+
+void
+kernel_stats::read(PtgKernelStats* stats) const
+{
+  stats->dispatch_count = dispatch_count;
+  stats->total_time = total_time;
+  // The minimum is reported as zero until there has been a dispatch.
+  stats->min_time = (stats->dispatch_count > 0) ? min_time.load() : 0;
+  stats->max_time = max_time;
+  stats->texel_count = texel_count;
+  stats->cycles = cycles;
+  stats->instructions = instructions;
+  stats->llc_misses = llc_misses;
+  stats->dtlb_misses = dtlb_misses;
+}
+
+void
+device_stats::record_texture(const uint64_t bytes)
+{
+  if (!is_enabled())
+    return;
+
+  texture_count.fetch_add(1, std::memory_order_relaxed);
+
+  texture_bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void
+device_stats::reset()
+{
+  raise_kernel.reset();
+  render_kernel.reset();
+  texture_count = 0;
+  texture_bytes = 0;
+}
+
+void
+device_stats::read(PtgDeviceStats* stats) const
+{
+  raise_kernel.read(&stats->raise_kernel);
+  render_kernel.read(&stats->render_kernel);
+  stats->texture_count = texture_count;
+  stats->texture_bytes = texture_bytes;
+}
+
+void
+memory_stats::update(const uint64_t live)
+{
+  live_bytes.store(live, std::memory_order_relaxed);
+
+  auto current_peak = peak_bytes.load(std::memory_order_relaxed);
+
+  while ((live > current_peak) && !peak_bytes.compare_exchange_weak(current_peak, live, std::memory_order_relaxed)) {
+  }
+}
+
+void
+memory_stats::read(PtgMemoryStats* stats) const
+{
+  stats->live_bytes = live_bytes;
+  stats->peak_bytes = peak_bytes;
+  stats->allocation_count = allocation_count;
+}
+
+} // namespace ptg
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <ptg.h>
+
+#include <atomic>
+
+#include <stdint.h>
+
+namespace ptg {
+
+struct perf_sample;
+
+/// @brief Counters for the dispatches of one kind of kernel.
+///        Every instance of the kernel adds to the same counters, which may happen from several threads at once.
+struct kernel_stats final
+{
+  std::atomic<uint64_t> dispatch_count{ 0 };
+
+  /// @brief The sum of the wall time of every dispatch, in nanoseconds.
+  std::atomic<uint64_t> total_time{ 0 };
+
+  /// @brief The wall time of the shortest dispatch, in nanoseconds.
+  std::atomic<uint64_t> min_time{ UINT64_MAX };
+
+  /// @brief The wall time of the longest dispatch, in nanoseconds.
+  std::atomic<uint64_t> max_time{ 0 };
+
+  /// @brief The number of texels processed, which leaves out regions that the kernel skipped.
+  std::atomic<uint64_t> texel_count{ 0 };
+
+  /// @brief The hardware events counted while processing tiles, summed over every thread.
+  std::atomic<uint64_t> cycles{ 0 };
+
+  std::atomic<uint64_t> instructions{ 0 };
+
+  std::atomic<uint64_t> llc_misses{ 0 };
+
+  std::atomic<uint64_t> dtlb_misses{ 0 };
+
+  /// @brief Adds a dispatch to the counters.
+  ///
+  /// @param time The wall time of the dispatch, in nanoseconds.
+  ///
+  /// @param texels The number of texels processed by the dispatch.
+  void record_dispatch(uint64_t time, uint64_t texels);
+
+  /// @brief Adds hardware events to the counters.
+  ///
+  /// @param events The number of events counted over an interval.
+  void record_events(const perf_sample& events);
+
+  /// @brief Sets every counter back to its initial value.
+  void reset();
+
+  /// @brief Copies the counters into the structure used by the C API.
+  void read(PtgKernelStats* stats) const;
+};
+
+/// @brief Counters for the work done by a device.
+///
+/// @details Collecting the counters is disabled by default. While disabled, the only cost is checking the flag once
+///          per dispatch and texture allocation, and no clocks are read.
+struct device_stats final
+{
+  /// @brief Whether the counters are being collected.
+  std::atomic<bool> enabled{ false };
+
+  /// @brief Whether hardware events are being counted. This is separate from the other counters, since reading
+  ///        hardware counters takes system calls.
+  std::atomic<bool> perf_enabled{ false };
+
+  /// @brief Counters for the raise kernel.
+  kernel_stats raise_kernel;
+
+  /// @brief Counters for the render kernel.
+  kernel_stats render_kernel;
+
+  /// @brief The number of textures allocated.
+  std::atomic<uint64_t> texture_count{ 0 };
+
+  /// @brief The number of bytes of texel data of the textures allocated, before any compression or paging.
+  std::atomic<uint64_t> texture_bytes{ 0 };
+
+  [[nodiscard]] bool is_enabled() const { return enabled.load(std::memory_order_relaxed); }
+
+  [[nodiscard]] bool is_perf_enabled() const { return perf_enabled.load(std::memory_order_relaxed); }
+
+  /// @brief Adds a texture allocation to the counters, if they are enabled.
+  ///
+  /// @param bytes The number of bytes of texel data in the texture.
+  void record_texture(uint64_t bytes);
+
+  /// @brief Sets every counter back to its initial value. This does not change whether the counters are enabled.
+  void reset();
+
+  /// @brief Copies the counters into the structure used by the C API.
+  void read(PtgDeviceStats* stats) const;
+};
+
+/// @brief Counters for the memory held by a device, or by the textures of one output or render.
+///
+/// @details Unlike the other counters, these are always collected, since they are only updated when memory is
+///          allocated or the counters are read. Memory that grows in between (such as the tiles of sparse textures
+///          written by a dispatch) is seen by the peak at the next update.
+struct memory_stats final
+{
+  /// @brief The number of bytes currently held.
+  std::atomic<uint64_t> live_bytes{ 0 };
+
+  /// @brief The largest number of live bytes seen.
+  std::atomic<uint64_t> peak_bytes{ 0 };
+
+  /// @brief The number of allocations made.
+  std::atomic<uint64_t> allocation_count{ 0 };
+
+  /// @brief Adds an allocation to the counters. The live bytes are updated separately.
+  void record_allocation() { allocation_count.fetch_add(1, std::memory_order_relaxed); }
+
+  /// @brief Sets the number of bytes currently held, raising the peak if it is exceeded.
+  ///
+  /// @param live The number of bytes held.
+  void update(uint64_t live);
+
+  /// @brief Copies the counters into the structure used by the C API.
+  void read(PtgMemoryStats* stats) const;
+};
+
+} // namespace ptg
@@ -0,0 +1,53 @@
+#include "host_allocator.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ptg {
+
+host_allocator::host_allocator(const PtgAllocator& callbacks)
+  : callbacks_(callbacks)
+{
+}
+
+void*
+host_allocator::allocate(const size_t size, const size_t alignment)
+{
+  return callbacks_.alloc(callbacks_.allocator_data, size, alignment);
+}
+
+void*
+host_allocator::reallocate(void* data, const size_t old_size, const size_t new_size, const size_t alignment)
+{
+  if (new_size == 0) {
+    deallocate(data, old_size);
+    return nullptr;
+  }
+
+  if (!data)
+    return allocate(new_size, alignment);
+
+  if (callbacks_.realloc)
+    return callbacks_.realloc(callbacks_.allocator_data, data, old_size, new_size, alignment);
+
+  // Without a realloc function, the contents are moved to a new allocation.
+
+  auto* new_data = allocate(new_size, alignment);
+  if (!new_data)
+    return nullptr;
+
+  std::memcpy(new_data, data, std::min(old_size, new_size));
+
+  deallocate(data, old_size);
+
+  return new_data;
+}
+
+void
+host_allocator::deallocate(void* data, const size_t size)
+{
+  if (data)
+    callbacks_.free(callbacks_.allocator_data, data, size);
+}
+
+} // namespace ptg
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "texel_allocator.hpp"
+
+#include <ptg.h>
+
+namespace ptg {
+
+/// @brief An allocator that allocates from the calling environment, through the callbacks of a @ref PtgAllocator.
+class host_allocator final : public memory_allocator
+{
+public:
+  /// @brief Constructs a new host allocator.
+  ///
+  /// @param callbacks The callbacks to allocate with. The alloc and free functions must not be null.
+  explicit host_allocator(const PtgAllocator& callbacks);
+
+  void* allocate(size_t size, size_t alignment) override;
+
+  void* reallocate(void* data, size_t old_size, size_t new_size, size_t alignment) override;
+
+  void deallocate(void* data, size_t size) override;
+
+private:
+  PtgAllocator callbacks_;
+};
+
+} // namespace ptg
@@ -0,0 +1,42 @@
+#include "host_scheduler.hpp"
+
+namespace ptg {
+
+namespace {
+
+/// @brief Passed to the host for each range of indices it processes.
+void
+run_range(void* task_data, const uint32_t begin, const uint32_t end)
+{
+  const auto& func = *static_cast<const std::function<void(uint32_t)>*>(task_data);
+
+  for (auto i = begin; i < end; i++)
+    func(i);
+}
+
+} // namespace
+
+host_scheduler::host_scheduler(const PtgScheduler& callbacks)
+  : callbacks_(callbacks)
+{
+}
+
+void
+host_scheduler::parallel_for(const uint32_t count, const std::function<void(uint32_t index)>& func)
+{
+  // A single index is not worth the round trip through the host.
+  if (count <= 1) {
+    for (uint32_t i = 0; i < count; i++)
+      func(i);
+    return;
+  }
+
+  // The function outlives the task, since this waits for the task before returning.
+  auto* task_data = const_cast<std::function<void(uint32_t)>*>(&func);
+
+  auto* task = callbacks_.submit(callbacks_.scheduler_data, count, run_range, task_data);
+
+  callbacks_.wait(callbacks_.scheduler_data, task);
+}
+
+} // namespace ptg
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "scheduler.hpp"
+
+#include <ptg.h>
+
+namespace ptg {
+
+/// @brief A scheduler that runs loops on the job system of the calling environment, through the callbacks of a
+///        @ref PtgScheduler.
+class host_scheduler final : public scheduler
+{
+public:
+  /// @brief Constructs a new host scheduler.
+  ///
+  /// @param callbacks The callbacks to submit loops with. The submit and wait functions must not be null.
+  explicit host_scheduler(const PtgScheduler& callbacks);
+
+  void parallel_for(uint32_t count, const std::function<void(uint32_t index)>& func) override;
+
+private:
+  PtgScheduler callbacks_;
+};
+
+} // namespace ptg
@@ -1,9 +1,16 @@
 #pragma once
 
+#include "kernel_params.hpp"
+
 #include <glm/glm.hpp>
 
+#include <type_traits>
+
+#include <stddef.h>
+
 namespace ptg {
 
+class buffer;
 class texture;
 
 class kernel
@@ -21,7 +28,52 @@ public:
 
   virtual ~kernel() = default;
 
-  virtual void dispatch(glm::uvec2 work_group_count) = 0;
+  /// @brief Runs the kernel over every work group.
+  ///
+  /// @param work_group_count The number of work groups in each axis.
+  void dispatch(const glm::uvec2 work_group_count) { dispatch(glm::uvec2(0, 0), work_group_count, work_group_count); }
+
+  /// @brief Runs the kernel over a rectangle of work groups.
+  ///        Work groups keep their position within the whole grid, so a kernel computes the same result for a work
+  ///        group whether it is dispatched alone or as part of the whole grid.
+  ///
+  /// @param work_group_origin The position of the first work group to run.
+  ///
+  /// @param work_group_count The number of work groups to run in each axis.
+  ///
+  /// @param work_group_bounds The number of work groups in each axis of the whole grid, which kernels derive the
+  ///                          bounds of their textures from. Work groups outside of these bounds are not run.
+  virtual void dispatch(glm::uvec2 work_group_origin, glm::uvec2 work_group_count, glm::uvec2 work_group_bounds) = 0;
+
+  /// @brief Indicates whether each texel that the kernel writes depends only on the texels at the same position in
+  ///        its inputs. If so, an input and an output may be bound to the same texture, so that it is updated in
+  ///        place instead of being copied into a new texture.
+  [[nodiscard]] virtual bool supports_in_place() const { return false; }
+
+  /// @brief Sets every parameter of the kernel from a parameter block, in one call.
+  ///        This avoids looking up and setting each uniform separately.
+  ///
+  /// @param params The parameter block, which must be the block type of the kernel (see kernel_params.hpp).
+  ///
+  /// @return True if the block was accepted, false if it does not match the kernel.
+  template<typename params_type>
+  bool set_params(const params_type& params)
+  {
+    static_assert(std::is_trivially_copyable<params_type>::value, "Parameter blocks must be trivially copyable.");
+
+    return set_param_block(&params, sizeof(params), params_type::type);
+  }
+
+  /// @brief Copies a parameter block into the kernel. Prefer calling @ref kernel::set_params.
+  ///
+  /// @param params A pointer to the parameter block.
+  ///
+  /// @param size The size of the parameter block, in bytes.
+  ///
+  /// @param type The type of the parameter block.
+  ///
+  /// @return True if the block was accepted, false if its type or size does not match the block of the kernel.
+  virtual bool set_param_block(const void* params, size_t size, param_block_type type) = 0;
 
   virtual int get_uniform_location(const char* name) = 0;
 
@@ -50,6 +102,13 @@ public:
   virtual void set_uniform_vec4(int location, const glm::vec4 value) = 0;
 
   virtual void set_active_texture(int texture_index, texture*) = 0;
+
+  /// @brief Binds a buffer to a buffer unit, so that the kernel can read it during dispatches.
+  ///
+  /// @param buffer_index The buffer unit to bind the buffer to.
+  ///
+  /// @param b The buffer to bind, or a null pointer to unbind the unit.
+  virtual void set_buffer(int buffer_index, buffer* b) = 0;
 };
 
 } // namespace ptg
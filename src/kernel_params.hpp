@@ -0,0 +1,79 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace ptg {
+
+/// @brief Identifies the type of a parameter block. Kernels compare it as well as the size of a block, so that a
+///        block of another type is rejected even if it happens to have the same size.
+enum class param_block_type
+{
+  raise,
+  render
+};
+
+/// @brief The parameters of the raise kernel, set all at once with @ref kernel::set_params.
+///        Each field can also be set on its own, as a uniform of the same name.
+struct raise_params final
+{
+  static constexpr param_block_type type = param_block_type::raise;
+
+  /// @brief The position of the brush, in world units. Only used if there is no brush buffer.
+  glm::vec2 brush_center{ 0, 0 };
+
+  /// @brief The distance at which the brush raises the terrain by half as much as at its center.
+  float brush_size{ 1 };
+
+  /// @brief The distance beyond which the brush has no effect, or zero if the brush has no bounds.
+  float brush_radius{ 0 };
+
+  /// @brief The size of a terrain cell, in world units.
+  float terrain_texel_size{ 1 };
+
+  /// @brief The position of the first terrain cell, in world units.
+  glm::vec2 terrain_origin{ 0, 0 };
+
+  /// @brief The texture unit that the heights are read from.
+  int input_texture{ -1 };
+
+  /// @brief The texture unit that the raised heights are written to. This may equal the input unit.
+  int output_texture{ -1 };
+
+  /// @brief The buffer unit holding the position of each brush to apply, as pairs of floats, or -1 to apply a
+  ///        single brush at the brush center. Brushes in a buffer are applied in order within a single dispatch.
+  int brush_buffer{ -1 };
+};
+
+/// @brief The parameters of the render kernel, set all at once with @ref kernel::set_params.
+///        Each field can also be set on its own, as a uniform of the same name.
+struct render_params final
+{
+  static constexpr param_block_type type = param_block_type::render;
+
+  /// @brief The pixel coordinate (coordinate within a pixel) to cast the ray from.
+  glm::vec2 pixel_coordinate{ 0.5f, 0.5f };
+
+  /// @brief The point on the hemisphere being sampled.
+  glm::vec3 unit_sphere_sample{ 0, 1, 0 };
+
+  /// @brief The position at which the camera is at.
+  glm::vec3 camera_position{ 0, 0, 0 };
+
+  /// @brief The rotation to apply to the camera direction.
+  ///        By default, the camera is looking down.
+  glm::vec3 camera_rotation{ 0, 0, 0 };
+
+  /// @brief The index of the texture containing the previous results.
+  int previous_texture{ -1 };
+
+  /// @brief The index of the texture to write the results to. This may equal the previous texture.
+  int next_texture{ -1 };
+
+  /// @brief The texture containing the rock layer height.
+  int rock_texture{ -1 };
+
+  /// @brief The texture containing the soil layer height.
+  int soil_texture{ -1 };
+};
+
+} // namespace ptg
@@ -1,18 +1,28 @@
 #pragma once
 
+#include <functional>
+#include <memory>
+
 namespace ptg {
 
 class kernel;
 
 /// @brief Used for mapping kernels to identifiers.
 ///        In this case, instead of a dictionary, direct member access is used instead.
+///
+/// @details Each entry creates a new instance of a kernel. An instance holds the state of an invocation (the
+///          parameters, bound textures and bound buffers), so objects that dispatch kernels keep instances of their
+///          own. Instances can be dispatched from different threads at the same time, while the kernel code is shared.
 struct kernel_registry final
 {
+  /// @brief Creates a new instance of a kernel.
+  using factory = std::function<std::unique_ptr<kernel>()>;
+
   /// @brief Used for raising the terrain at a certain location.
-  kernel* raise_kernel{ nullptr };
+  factory raise_kernel;
 
   /// @brief Used for rendering the terrain.
-  kernel* render_kernel{ nullptr };
+  factory render_kernel;
 };
 
 } // namespace ptg
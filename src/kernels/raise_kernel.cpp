@@ -6,58 +6,138 @@ namespace ptg {
 
 raise_kernel::raise_kernel()
 {
-  register_uniform("brush_center", &brush_center_);
+  register_params(params_);
 
-  register_uniform("brush_size", &brush_size_);
+  register_uniform("brush_center", &params_.brush_center);
 
-  register_uniform("terrain_texel_size", &terrain_texel_size_);
+  register_uniform("brush_size", &params_.brush_size);
 
-  register_uniform("input_texture", &input_texture_);
+  register_uniform("brush_radius", &params_.brush_radius);
 
-  register_uniform("output_texture", &output_texture_);
+  register_uniform("terrain_texel_size", &params_.terrain_texel_size);
+
+  register_uniform("terrain_origin", &params_.terrain_origin);
+
+  register_uniform("input_texture", &params_.input_texture);
+
+  register_uniform("output_texture", &params_.output_texture);
+
+  register_uniform("brush_buffer", &params_.brush_buffer);
+}
+
+tile_access
+raise_kernel::get_texture_access(const int texture_index) const
+{
+  if (texture_index == params_.output_texture)
+    return (texture_index == params_.input_texture) ? tile_access::read_write : tile_access::write_only;
+
+  return tile_access::read_only;
+}
+
+buffer_span<const glm::vec2>
+raise_kernel::get_brush_centers() const
+{
+  if (params_.brush_buffer >= 0)
+    return get_buffer<glm::vec2>(params_.brush_buffer);
+
+  return buffer_span<const glm::vec2>{ &params_.brush_center, 1 };
 }
 
 void
-raise_kernel::local_dispatch(const glm::uvec2 work_group_id, const glm::uvec2 work_group_count)
+raise_kernel::begin_dispatch(const glm::uvec2)
 {
-  const auto* input = static_cast<const glm::vec4*>(get_texture(input_texture_)->get_data_pointer());
+  // The brush center is moved into the frame of the terrain origin, so that terrains baked at different
+  // origins (such as neighbouring chunks) evaluate the brush at consistent world positions.
 
-  auto* output = static_cast<glm::vec4*>(get_texture(output_texture_)->get_data_pointer());
+  const auto centers = get_brush_centers();
 
-  const auto p_min = work_group_id * work_group_size();
+  brush_centers_.resize(centers.size);
 
-  const auto p_max = (work_group_id + glm::uvec2(1, 1)) * work_group_size();
+  for (size_t i = 0; i < centers.size; i++)
+    brush_centers_[i] = centers[i] - params_.terrain_origin;
+}
 
-  const glm::vec4 brush_center_x{ brush_center_.x, brush_center_.x, brush_center_.x, brush_center_.x };
-  const glm::vec4 brush_center_y{ brush_center_.y, brush_center_.y, brush_center_.y, brush_center_.y };
+bool
+raise_kernel::skip_region(const glm::uvec2 origin, const glm::uvec2 extent)
+{
+  if (params_.brush_radius <= 0.0f)
+    return false;
 
-  const auto texel_bounds = work_group_size() * work_group_count;
+  // This mirrors the texel positions computed in the dispatch, so that the bounds enclose every value in the region.
 
-  const auto distance_scale = 1.0f / brush_size_;
+  const auto region_min = glm::vec2(origin) * 2.0f * params_.terrain_texel_size;
 
-  for (uint32_t y = p_min.y; y < p_max.y; y++) {
+  const auto region_max = glm::vec2(origin + extent - glm::uvec2(1, 1)) * 2.0f * params_.terrain_texel_size + 1.0f;
 
-    for (uint32_t x = p_min.x; x < p_max.x; x++) {
+  for (const auto& brush_center : brush_centers_) {
 
-      const auto x0 = (x * 2 * terrain_texel_size_) + 0;
-      const auto x1 = (x * 2 * terrain_texel_size_) + 1;
+    const auto delta = brush_center - glm::clamp(brush_center, region_min, region_max);
 
-      const auto y0 = (y * 2 * terrain_texel_size_) + 0;
-      const auto y1 = (y * 2 * terrain_texel_size_) + 1;
+    if (glm::dot(delta, delta) <= (params_.brush_radius * params_.brush_radius))
+      return false;
+  }
+
+  auto* input = get_texture(params_.input_texture);
 
-      const glm::vec4 pos_x{ x0, x1, x0, x1 };
-      const glm::vec4 pos_y{ y0, y0, y1, y1 };
+  auto* output = get_texture(params_.output_texture);
 
-      const auto delta_x = pos_x - brush_center_x;
-      const auto delta_y = pos_y - brush_center_y;
+  if (input == output)
+    return true;
 
-      const auto distance = glm::sqrt(delta_x * delta_x + delta_y * delta_y);
+  glm::vec4 value;
 
-      const auto texel_index = (y * texel_bounds.x) + x;
+  if (!input->is_constant(origin, extent, &value))
+    return false;
 
-      output[texel_index] = input[texel_index] + glm::vec4(1.0f) / (glm::vec4(1.0f) + distance * distance_scale);
-    }
+  output->fill_region(origin, extent, value);
+
+  return true;
+}
+
+raise_kernel::tile_state
+raise_kernel::begin_tile(const glm::uvec2, const texel_tile* tiles) const
+{
+  tile_state state;
+  state.input = &tiles[params_.input_texture];
+  state.output = &tiles[params_.output_texture];
+  state.brush_centers = buffer_span<const glm::vec2>{ brush_centers_.data(), brush_centers_.size() };
+  state.distance_scale = 1.0f / params_.brush_size;
+  return state;
+}
+
+void
+raise_kernel::process_texel(const tile_state& state, const glm::uvec2 texel) const
+{
+  const auto x0 = (texel.x * 2 * params_.terrain_texel_size) + 0;
+  const auto x1 = (texel.x * 2 * params_.terrain_texel_size) + 1;
+
+  const auto y0 = (texel.y * 2 * params_.terrain_texel_size) + 0;
+  const auto y1 = (texel.y * 2 * params_.terrain_texel_size) + 1;
+
+  const glm::vec4 pos_x{ x0, x1, x0, x1 };
+  const glm::vec4 pos_y{ y0, y0, y1, y1 };
+
+  // Brushes are added one at a time, in order, so the result matches applying them in separate dispatches.
+  auto value = state.input->at(texel);
+
+  for (const auto& brush_center : state.brush_centers) {
+
+    const auto delta_x = pos_x - glm::vec4(brush_center.x);
+    const auto delta_y = pos_y - glm::vec4(brush_center.y);
+
+    const auto distance = glm::sqrt(delta_x * delta_x + delta_y * delta_y);
+
+    auto weight = glm::vec4(1.0f) / (glm::vec4(1.0f) + distance * state.distance_scale);
+
+    if (params_.brush_radius > 0.0f)
+      weight *= glm::step(distance, glm::vec4(params_.brush_radius));
+
+    value += weight;
   }
+
+  state.output->at(texel) = value;
 }
 
+template class cpu_kernel_base<raise_kernel, 16, 4>;
+
 } // namespace ptg
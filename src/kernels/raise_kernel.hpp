@@ -1,26 +1,59 @@
 #pragma once
 
 #include "../cpu_kernel.hpp"
+#include "../kernel_params.hpp"
+
+#include <vector>
 
 namespace ptg {
 
-class raise_kernel final : public cpu_kernel
+/// @brief Raises the terrain around one or more brushes.
+///        Blocks are a few rows of 16 texels, so that the texels of a row can be processed together.
+class raise_kernel final : public cpu_kernel_base<raise_kernel, 16, 4>
 {
 public:
   raise_kernel();
 
-  void local_dispatch(const glm::uvec2 work_group_id, const glm::uvec2 work_group_count) override;
+  [[nodiscard]] tile_access get_texture_access(int texture_index) const override;
+
+  [[nodiscard]] bool supports_in_place() const override { return true; }
+
+  [[nodiscard]] const char* get_name() const override { return "raise"; }
+
+  bool skip_region(glm::uvec2 origin, glm::uvec2 extent) override;
+
+  void begin_dispatch(glm::uvec2 work_group_count) override;
 
 private:
-  float terrain_texel_size_{ 1 };
+  friend cpu_kernel_base<raise_kernel, 16, 4>;
+
+  /// @brief The state used to process the texels of a tile.
+  struct tile_state final
+  {
+    const texel_tile* input{ nullptr };
 
-  glm::vec2 brush_center_{ 0, 0 };
+    const texel_tile* output{ nullptr };
 
-  float brush_size_{ 1 };
+    /// @brief The brush centers, relative to the terrain origin.
+    buffer_span<const glm::vec2> brush_centers;
 
-  int input_texture_{ -1 };
+    float distance_scale{ 1 };
+  };
 
-  int output_texture_{ -1 };
+  [[nodiscard]] tile_state begin_tile(glm::uvec2 work_group_count, const texel_tile* tiles) const;
+
+  void process_texel(const tile_state& state, glm::uvec2 texel) const;
+
+  /// @brief Gets the center of each brush to apply in the dispatch.
+  [[nodiscard]] buffer_span<const glm::vec2> get_brush_centers() const;
+
+  raise_params params_;
+
+  /// @brief The brush centers of the current dispatch, moved into the frame of the terrain origin.
+  ///        The vector keeps its capacity between dispatches, so it is only reallocated when the brush count grows.
+  std::vector<glm::vec2> brush_centers_;
 };
 
+extern template class cpu_kernel_base<raise_kernel, 16, 4>;
+
 } // namespace ptg
@@ -10,68 +10,77 @@ namespace ptg {
 
 render_kernel::render_kernel()
 {
-  register_uniform("pixel_coordinate", &pixel_coordinate_);
+  register_params(params_);
 
-  register_uniform("unit_sphere_sample", &unit_sphere_sample_);
+  register_uniform("pixel_coordinate", &params_.pixel_coordinate);
 
-  register_uniform("camera_position", &camera_position_);
+  register_uniform("unit_sphere_sample", &params_.unit_sphere_sample);
 
-  register_uniform("camera_rotation", &camera_rotation_);
+  register_uniform("camera_position", &params_.camera_position);
 
-  register_uniform("previous_texture", &previous_texture_);
+  register_uniform("camera_rotation", &params_.camera_rotation);
 
-  register_uniform("next_texture", &next_texture_);
+  register_uniform("previous_texture", &params_.previous_texture);
 
-  register_uniform("rock_texture", &rock_texture_);
+  register_uniform("next_texture", &params_.next_texture);
 
-  register_uniform("soil_texture", &soil_texture_);
+  register_uniform("rock_texture", &params_.rock_texture);
+
+  register_uniform("soil_texture", &params_.soil_texture);
 }
 
-void
-render_kernel::local_dispatch(const glm::uvec2 work_group_id, const glm::uvec2 work_group_count)
+tile_access
+render_kernel::get_texture_access(const int texture_index) const
 {
-  const auto* previous_texture = static_cast<const glm::vec4*>(get_texture(previous_texture_)->get_data_pointer());
+  if (texture_index == params_.next_texture)
+    return (texture_index == params_.previous_texture) ? tile_access::read_write : tile_access::write_only;
 
-  auto* next_texture = static_cast<glm::vec4*>(get_texture(next_texture_)->get_data_pointer());
+  return tile_access::read_only;
+}
 
-  const auto p_min = (work_group_id + glm::uvec2(0, 0)) * work_group_size();
-  const auto p_max = (work_group_id + glm::uvec2(1, 1)) * work_group_size();
+void
+render_kernel::begin_dispatch(const glm::uvec2 work_group_count)
+{
   const auto image_bounds = work_group_count * work_group_size();
 
-  const auto x_scale = 1.0f / static_cast<float>(image_bounds.x);
-  const auto y_scale = 1.0f / static_cast<float>(image_bounds.y);
-
-  const glm::mat3 rotation = rotate(glm::radians(camera_rotation_.z), glm::vec3(0, 0, 1)) *
-                             rotate(glm::radians(camera_rotation_.y), glm::vec3(0, 1, 0)) *
-                             rotate(glm::radians(camera_rotation_.x), glm::vec3(1, 0, 0));
-
-  const auto dir = normalize(rotation * glm::vec3(0, -1, 0));
-
-  const auto up = normalize(rotation * glm::vec3(0, 0, 1));
-
-  const auto right = normalize(rotation * glm::vec3(1, 0, 0));
+  const glm::mat3 rotation = rotate(glm::radians(params_.camera_rotation.z), glm::vec3(0, 0, 1)) *
+                             rotate(glm::radians(params_.camera_rotation.y), glm::vec3(0, 1, 0)) *
+                             rotate(glm::radians(params_.camera_rotation.x), glm::vec3(1, 0, 0));
 
-  for (uint32_t y = p_min.y; y < p_max.y; y++) {
+  frame_.pixel_scale = glm::vec2(1.0f / static_cast<float>(image_bounds.x), 1.0f / static_cast<float>(image_bounds.y));
+  frame_.dir = normalize(rotation * glm::vec3(0, -1, 0));
+  frame_.up = normalize(rotation * glm::vec3(0, 0, 1));
+  frame_.right = normalize(rotation * glm::vec3(1, 0, 0));
+}
 
-    for (uint32_t x = p_min.x; x < p_max.x; x++) {
+render_kernel::tile_state
+render_kernel::begin_tile(const glm::uvec2, const texel_tile* tiles) const
+{
+  tile_state state;
+  state.previous_texture = &tiles[params_.previous_texture];
+  state.next_texture = &tiles[params_.next_texture];
+  state.frame = frame_;
+  return state;
+}
 
-      const auto u = (static_cast<float>(x) + pixel_coordinate_.x) * x_scale;
-      const auto v = (static_cast<float>(y) + pixel_coordinate_.y) * y_scale;
+void
+render_kernel::process_texel(const tile_state& state, const glm::uvec2 texel) const
+{
+  const auto& frame = state.frame;
 
-      const auto dx = u * 2 - 1;
-      const auto dy = v * 2 - 1;
+  const auto u = (static_cast<float>(texel.x) + params_.pixel_coordinate.x) * frame.pixel_scale.x;
+  const auto v = (static_cast<float>(texel.y) + params_.pixel_coordinate.y) * frame.pixel_scale.y;
 
-      const auto ray_dir = glm::normalize(dir + (up * dy) + (right * dx));
+  const auto dx = u * 2 - 1;
+  const auto dy = v * 2 - 1;
 
-      const auto r = ray{ camera_position_, ray_dir };
+  const auto ray_dir = glm::normalize(frame.dir + (frame.up * dy) + (frame.right * dx));
 
-      const auto color = trace(r);
+  const auto r = ray{ params_.camera_position, ray_dir };
 
-      const auto texel_index = y * image_bounds.x + x;
+  const auto color = trace(r);
 
-      next_texture[texel_index] = glm::vec4(color, 1.0f) + previous_texture[texel_index];
-    }
-  }
+  state.next_texture->at(texel) = glm::vec4(color, 1.0f) + state.previous_texture->at(texel);
 }
 
 glm::vec3
@@ -84,7 +93,7 @@ render_kernel::trace(const ray& r) const
 
   constexpr auto shadow_bias = 1e-3f;
 
-  const auto second_ray_dir = unit_sphere_sample_ * glm::sign(dot(h.normal, unit_sphere_sample_));
+  const auto second_ray_dir = params_.unit_sphere_sample * glm::sign(dot(h.normal, params_.unit_sphere_sample));
 
   const auto second_ray_org = r.org + r.dir * (h.distance - shadow_bias);
 
@@ -228,4 +237,6 @@ render_kernel::on_miss(const glm::vec3& ray_org, const glm::vec3& ray_dir) const
   return lo + ((hi - lo) * level);
 }
 
+template class cpu_kernel_base<render_kernel, 8, 8>;
+
 } // namespace ptg
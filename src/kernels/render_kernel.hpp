@@ -1,17 +1,58 @@
 #pragma once
 
 #include "../cpu_kernel.hpp"
+#include "../kernel_params.hpp"
 
 namespace ptg {
 
-class render_kernel final : public cpu_kernel
+/// @brief Path traces the terrain, adding one sample per pixel to the previous results.
+///        Rays of neighbouring pixels take similar paths, so pixels are processed in square blocks.
+class render_kernel final : public cpu_kernel_base<render_kernel, 8, 8>
 {
 public:
   render_kernel();
 
-  void local_dispatch(glm::uvec2 work_group_id, glm::uvec2 work_group_count) override;
+  [[nodiscard]] tile_access get_texture_access(int texture_index) const override;
+
+  [[nodiscard]] bool supports_in_place() const override { return true; }
+
+  [[nodiscard]] const char* get_name() const override { return "render"; }
+
+  void begin_dispatch(glm::uvec2 work_group_count) override;
 
 private:
+  friend cpu_kernel_base<render_kernel, 8, 8>;
+
+  /// @brief The camera frame, which is the same for every pixel of a dispatch.
+  struct camera_frame final
+  {
+    /// @brief Converts pixel positions to the range [0, 1].
+    glm::vec2 pixel_scale{ 1, 1 };
+
+    /// @brief The direction the camera is looking in.
+    glm::vec3 dir{ 0, -1, 0 };
+
+    /// @brief The up direction of the image plane.
+    glm::vec3 up{ 0, 0, 1 };
+
+    /// @brief The right direction of the image plane.
+    glm::vec3 right{ 1, 0, 0 };
+  };
+
+  /// @brief The state used to process the pixels of a tile.
+  struct tile_state final
+  {
+    const texel_tile* previous_texture{ nullptr };
+
+    const texel_tile* next_texture{ nullptr };
+
+    camera_frame frame;
+  };
+
+  [[nodiscard]] tile_state begin_tile(glm::uvec2 work_group_count, const texel_tile* tiles) const;
+
+  void process_texel(const tile_state& state, glm::uvec2 texel) const;
+
   /// @brief Stores data associated with a ray.
   struct ray final
   {
@@ -85,30 +126,10 @@ private:
   /// @return The color of the background, where the ray is pointing at.
   [[nodiscard]] glm::vec3 on_miss(const glm::vec3& ray_org, const glm::vec3& ray_dir) const;
 
-  /// @brief The texture containing the rock layer height.
-  int rock_texture_{ -1 };
-
-  /// @brief The texture containing the soil layer height.
-  int soil_texture_{ -1 };
+  render_params params_;
 
-  /// @brief The index of the texture containing the previous results.
-  int previous_texture_{ -1 };
-
-  /// @brief The index of the texture to write the results to.
-  int next_texture_{ -1 };
-
-  /// @brief The point on the hemisphere being sampled.
-  glm::vec3 unit_sphere_sample_{ 0, 1, 0 };
-
-  /// @brief The pixel coordinate (coordinate within a pixel) to cast the ray from.
-  glm::vec2 pixel_coordinate_{ 0.5f, 0.5f };
-
-  /// @brief The position at which the camera is at.
-  glm::vec3 camera_position_{ 0, 0, 0 };
-
-  /// @brief The rotation to apply to the camera direction.
-  ///        By default, the camera is looking down.
-  glm::vec3 camera_rotation_{ 0, 0, 0 };
+  /// @brief The camera frame of the current dispatch, computed in @ref render_kernel::begin_dispatch.
+  camera_frame frame_;
 
   /// @brief The minimum distance allowed for a ray intersection.
   const float near_{ 0.01f };
@@ -117,4 +138,6 @@ private:
   const float far_{ 2000.0f };
 };
 
+extern template class cpu_kernel_base<render_kernel, 8, 8>;
+
 } // namespace ptg
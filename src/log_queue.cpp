@@ -0,0 +1,141 @@
+#include "log_queue.hpp"
+
+#include <string>
+
+#include <string.h>
+
+namespace ptg {
+
+log_queue::log_queue(const size_t capacity, void* logger_data, ptg_log_callback logger_func)
+  : logger_data_(logger_data)
+    , logger_func_(logger_func)
+{
+  size_t slot_count = 1;
+
+  while (slot_count < capacity)
+    slot_count *= 2;
+
+  slots_.reset(new slot[slot_count]);
+
+  mask_ = slot_count - 1;
+
+  for (size_t i = 0; i < slot_count; i++)
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+log_queue::~log_queue()
+{
+  if (thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> guard(thread_lock_);
+      thread_stop_ = true;
+    }
+
+    thread_wake_.notify_one();
+
+    thread_.join();
+  }
+
+  drain();
+}
+
+bool
+log_queue::push(const PtgSeverity severity, const char* msg)
+{
+  auto position = write_position_.load(std::memory_order_relaxed);
+
+  slot* s = nullptr;
+
+  for (;;) {
+
+    s = &slots_[position & mask_];
+
+    const auto sequence = s->sequence.load(std::memory_order_acquire);
+
+    const auto difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+    if (difference == 0) {
+      // The slot is free, so it is claimed by moving the write position past it.
+      if (write_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+        break;
+    } else if (difference < 0) {
+      // The slot still holds a record from the previous lap, so the ring is full.
+      dropped_count_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    } else {
+      // Another thread claimed the slot first.
+      position = write_position_.load(std::memory_order_relaxed);
+    }
+  }
+
+  s->severity = severity;
+
+  const auto length = strnlen(msg, max_message_size - 1);
+
+  memcpy(s->message, msg, length);
+
+  s->message[length] = 0;
+
+  s->sequence.store(position + 1, std::memory_order_release);
+
+  return true;
+}
+
+size_t
+log_queue::drain()
+{
+  std::lock_guard<std::mutex> guard(drain_lock_);
+
+  size_t count = 0;
+
+  for (;;) {
+
+    auto& s = slots_[read_position_ & mask_];
+
+    // Draining stops at the first slot that has not been written yet, even if later slots have been.
+    if (s.sequence.load(std::memory_order_acquire) != (read_position_ + 1))
+      break;
+
+    logger_func_(logger_data_, s.severity, s.message);
+
+    s.sequence.store(read_position_ + mask_ + 1, std::memory_order_release);
+
+    read_position_++;
+
+    count++;
+  }
+
+  const auto dropped_count = dropped_count_.exchange(0, std::memory_order_relaxed);
+
+  if (dropped_count > 0) {
+    const auto msg = std::to_string(dropped_count) + " log records were dropped because the log queue was full.";
+    logger_func_(logger_data_, PTG_WARN, msg.c_str());
+  }
+
+  return count;
+}
+
+void
+log_queue::start_thread(const std::chrono::milliseconds interval)
+{
+  thread_ = std::thread([this, interval] { run(interval); });
+}
+
+void
+log_queue::run(const std::chrono::milliseconds interval)
+{
+  std::unique_lock<std::mutex> lock(thread_lock_);
+
+  while (!thread_stop_) {
+
+    lock.unlock();
+
+    drain();
+
+    lock.lock();
+
+    thread_wake_.wait_for(lock, interval, [this] { return thread_stop_; });
+  }
+}
+
+} // namespace ptg
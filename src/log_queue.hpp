@@ -0,0 +1,119 @@
+#pragma once
+
+#include <ptg.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace ptg {
+
+/// @brief Queues log records so that they can be passed to the logger function later, on another thread.
+///
+/// @details Records are pushed without locking or allocating, from any number of threads, into a fixed ring of
+///          slots. When the ring is full, new records are dropped (and counted) rather than waiting for room, so
+///          logging never stalls the thread that logs. Records are passed to the logger function, in the order they
+///          were pushed, when the queue is drained, either explicitly or by a thread of the queue's own.
+class log_queue final
+{
+public:
+  /// @brief The largest number of bytes of a message that is kept, including the null terminator.
+  ///        Longer messages are truncated.
+  static constexpr size_t max_message_size = 256;
+
+  /// @brief Constructs a new log queue.
+  ///
+  /// @param capacity The number of records that can be queued. This is rounded up to a power of two.
+  ///
+  /// @param logger_data The pointer to pass to the logger function.
+  ///
+  /// @param logger_func The function to pass records to when draining. This must not be null.
+  log_queue(size_t capacity, void* logger_data, ptg_log_callback logger_func);
+
+  log_queue(const log_queue&) = delete;
+
+  log_queue(log_queue&&) = delete;
+
+  log_queue& operator=(const log_queue&) = delete;
+
+  log_queue& operator=(log_queue&&) = delete;
+
+  /// @brief Stops the drain thread, if there is one, and passes any remaining records to the logger function.
+  ~log_queue();
+
+  /// @brief Queues a log record.
+  ///
+  /// @param severity The severity of the record.
+  ///
+  /// @param msg The message of the record, which is copied.
+  ///
+  /// @return True if the record was queued, false if the queue was full and the record was dropped.
+  bool push(PtgSeverity severity, const char* msg);
+
+  /// @brief Passes the queued records to the logger function, on the calling thread.
+  ///        If records were dropped since the last drain, a warning saying how many follows them.
+  ///        Several threads may drain at once, in which case they take turns.
+  ///
+  /// @return The number of records passed to the logger function.
+  size_t drain();
+
+  /// @brief Starts a thread that drains the queue periodically, until the queue is destroyed.
+  ///
+  /// @param interval The time to wait between drains.
+  void start_thread(std::chrono::milliseconds interval);
+
+private:
+  /// @brief A slot in the ring.
+  ///
+  /// @details The sequence number of a slot is equal to the position it is next written at while it is free, and one
+  ///          more than that once a record has been written to it. The drainer frees it again by advancing it by the
+  ///          size of the ring.
+  struct slot final
+  {
+    std::atomic<size_t> sequence{ 0 };
+
+    PtgSeverity severity{ PTG_INFO };
+
+    char message[max_message_size];
+  };
+
+  /// @brief The loop of the drain thread.
+  void run(std::chrono::milliseconds interval);
+
+  std::unique_ptr<slot[]> slots_;
+
+  size_t mask_{ 0 };
+
+  void* logger_data_{ nullptr };
+
+  ptg_log_callback logger_func_{ nullptr };
+
+  /// @brief The position that the next record is written at.
+  ///        This is kept on its own cache line, since every logging thread writes to it.
+  alignas(64) std::atomic<size_t> write_position_{ 0 };
+
+  /// @brief The position of the next record to drain. Only accessed while holding @ref log_queue::drain_lock_.
+  alignas(64) size_t read_position_{ 0 };
+
+  /// @brief The number of records dropped since the last drain.
+  std::atomic<uint64_t> dropped_count_{ 0 };
+
+  /// @brief Makes threads that drain at the same time take turns. Logging threads never take this lock.
+  std::mutex drain_lock_;
+
+  std::thread thread_;
+
+  std::mutex thread_lock_;
+
+  std::condition_variable thread_wake_;
+
+  bool thread_stop_{ false };
+};
+
+} // namespace ptg
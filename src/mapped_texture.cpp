@@ -0,0 +1,103 @@
+#include "mapped_texture.hpp"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace ptg {
+
+namespace {
+
+/// The texels start on a page boundary, so that readers can map them directly.
+constexpr uint64_t data_offset = 4096;
+
+constexpr char magic[8] = { 'P', 'T', 'G', 'T', 'E', 'X', '0', '1' };
+
+} // namespace
+
+std::unique_ptr<mapped_texture>
+mapped_texture::create(const char* path, const uint32_t size, const uint32_t flags)
+{
+  const int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    return nullptr;
+
+  const size_t mapping_size = data_offset + (static_cast<size_t>(size) * size * sizeof(glm::vec4));
+
+  // Extending the file leaves it zero filled, without writing the zeros to disk.
+  if (ftruncate(fd, static_cast<off_t>(mapping_size)) != 0) {
+    close(fd);
+    return nullptr;
+  }
+
+  int mmap_flags = MAP_SHARED;
+
+#ifdef MAP_POPULATE
+  if (flags & map_flag_populate)
+    mmap_flags |= MAP_POPULATE;
+#endif
+
+  void* mapping = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, mmap_flags, fd, 0);
+  if (mapping == MAP_FAILED) {
+    close(fd);
+    return nullptr;
+  }
+
+#ifdef MADV_HUGEPAGE
+  // This is only a hint. It takes effect on file systems that support huge pages, such as tmpfs.
+  if (flags & map_flag_huge_pages)
+    madvise(mapping, mapping_size, MADV_HUGEPAGE);
+#else
+  (void)flags;
+#endif
+
+  mapped_texture_header header{};
+  std::memcpy(header.magic, magic, sizeof(magic));
+  header.size = size;
+  header.texel_format = 0;
+  header.data_offset = data_offset;
+
+  std::memcpy(mapping, &header, sizeof(header));
+
+  return std::unique_ptr<mapped_texture>(new mapped_texture(size, fd, mapping, mapping_size));
+}
+
+mapped_texture::mapped_texture(const uint32_t size, const int file_descriptor, void* mapping, const size_t mapping_size)
+  : size_(size)
+    , file_descriptor_(file_descriptor)
+    , mapping_(mapping)
+    , mapping_size_(mapping_size)
+    , texels_(reinterpret_cast<glm::vec4*>(static_cast<char*>(mapping) + data_offset))
+{
+}
+
+mapped_texture::~mapped_texture()
+{
+  munmap(mapping_, mapping_size_);
+
+  close(file_descriptor_);
+}
+
+void
+mapped_texture::read_data(float* data)
+{
+  std::memcpy(data, texels_, static_cast<size_t>(size_) * size_ * sizeof(glm::vec4));
+}
+
+texture_desc
+mapped_texture::get_desc() const
+{
+  texture_desc desc;
+  desc.size = size_;
+  return desc;
+}
+
+texel_tile
+mapped_texture::map_region(const glm::uvec2 origin, const glm::uvec2 size, tile_access)
+{
+  return texel_tile{ &texels_[(static_cast<size_t>(origin.y) * size_) + origin.x], origin, size, size_ };
+}
+
+} // namespace ptg
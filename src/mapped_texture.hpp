@@ -0,0 +1,86 @@
+#pragma once
+
+#include "texture.hpp"
+
+#include <memory>
+
+namespace ptg {
+
+/// @brief The header at the start of a mapped texture file.
+///        The texels follow at the data offset as row-major RGBA 32-bit floats.
+struct mapped_texture_header final
+{
+  /// @brief Identifies the file as a mapped texture.
+  char magic[8];
+
+  /// @brief The size of the texture, in both axes.
+  uint32_t size;
+
+  /// @brief The format of each texel. Zero means four 32-bit floats.
+  uint32_t texel_format;
+
+  /// @brief The offset, in bytes, from the start of the file to the first texel.
+  uint64_t data_offset;
+};
+
+/// @brief A texture whose texels are stored in a memory-mapped file.
+///        Kernels write straight into the file, so the result persists after the texture is destroyed and other
+///        processes can map the file while it is being written.
+class mapped_texture final : public texture
+{
+public:
+  /// @brief The size of the tiles that kernels process this texture in.
+  ///        Rows are stored contiguously, so this only affects how work is split up.
+  static constexpr uint32_t tile_size() { return 64; }
+
+  /// @brief Creates a new mapped texture, replacing any file that exists at the path.
+  ///
+  /// @param path The path of the file to create.
+  ///
+  /// @param size The size of the texture, in both axes.
+  ///
+  /// @param flags A combination of @ref map_flags.
+  ///
+  /// @return A new mapped texture, or a null pointer if the file could not be created or mapped.
+  static std::unique_ptr<mapped_texture> create(const char* path, uint32_t size, uint32_t flags);
+
+  mapped_texture(const mapped_texture&) = delete;
+
+  ~mapped_texture() override;
+
+  void read_data(float* data) override;
+
+  [[nodiscard]] uint32_t get_size() const override { return size_; }
+
+  /// @note A copy of a mapped texture is kept in memory, since it cannot share the file.
+  [[nodiscard]] texture_desc get_desc() const override;
+
+  /// @note The texels live in the page cache of the file, which the system can write back and reclaim at any time, so
+  ///       they are not counted.
+  [[nodiscard]] size_t get_memory_usage() const override { return 0; }
+
+  [[nodiscard]] uint32_t get_tile_size() const override { return tile_size(); }
+
+  texel_tile map_region(glm::uvec2 origin, glm::uvec2 size, tile_access access) override;
+
+  void unmap_region(const texel_tile&, tile_access) override {}
+
+  void* get_data_pointer() override { return texels_; }
+
+  [[nodiscard]] const void* get_data_pointer() const override { return texels_; }
+
+private:
+  mapped_texture(uint32_t size, int file_descriptor, void* mapping, size_t mapping_size);
+
+  const uint32_t size_{ 0 };
+
+  int file_descriptor_{ -1 };
+
+  void* mapping_{ nullptr };
+
+  size_t mapping_size_{ 0 };
+
+  glm::vec4* texels_{ nullptr };
+};
+
+} // namespace ptg
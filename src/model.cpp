@@ -19,6 +19,12 @@ model::set_brush_size(const float brush_size)
   edit()->brush_size = brush_size;
 }
 
+void
+model::set_brush_radius(const float brush_radius)
+{
+  edit()->brush_radius = brush_radius;
+}
+
 void
 model::begin_path()
 {
@@ -27,7 +33,10 @@ model::begin_path()
     return;
   }
 
-  active_path_ = path{ current()->brush_size, {}, current()->active_layer };
+  active_path_ = path{ current()->brush_size,
+                       std::vector<float, texel_allocator<float>>(texel_allocator<float>(device_->get_allocator())),
+                       current()->active_layer,
+                       current()->brush_radius };
 }
 
 void
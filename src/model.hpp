@@ -1,6 +1,7 @@
 #pragma once
 
 #include "device.hpp"
+#include "texel_allocator.hpp"
 
 #include <optional>
 #include <vector>
@@ -17,11 +18,14 @@ struct path final
   /// The size of the brush applying the path.
   float brush_size{ 16.0f };
 
-  /// The coordinates of each point in the path.
-  std::vector<float> xy_coordinates;
+  /// The coordinates of each point in the path, allocated by the device that the model was created with.
+  std::vector<float, texel_allocator<float>> xy_coordinates;
 
   /// The layer on which to apply this path.
   PtgLayer layer;
+
+  /// The distance beyond which the brush has no effect, or zero if the brush has no bounds.
+  float brush_radius{ 0.0f };
 };
 
 enum class operation_kind
@@ -43,6 +47,9 @@ struct memento final
   /// @brief The size of the brush to be used in the next path.
   float brush_size{ 4.0f };
 
+  /// @brief The radius of the brush to be used in the next path, or zero if the brush has no bounds.
+  float brush_radius{ 0.0f };
+
   /// @brief The number of meters per axis.
   float meters_per_axis{ 1000.0f };
 
@@ -66,6 +73,11 @@ public:
 
   void set_brush_size(float brush_size);
 
+  /// @brief Sets the distance beyond which the brush of the next path has no effect.
+  ///
+  /// @param brush_radius The radius of the brush, or zero for a brush without bounds.
+  void set_brush_radius(float brush_radius);
+
   void begin_path();
 
   void end_path();
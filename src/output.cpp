@@ -1,61 +1,189 @@
 #include "output.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
 #include <vector>
 
 #include "kernel.hpp"
+#include "kernel_params.hpp"
 #include "kernel_registry.hpp"
+#include "trace.hpp"
 
 namespace ptg {
 
 // Note that texture axis sizes for terrain output are divided by two
 // since a single texel contains two values per axis (a texel is vec4).
 
-output::output(std::shared_ptr<device> dev, const uint32_t terrain_size)
+namespace {
+
+texture_desc
+make_layer_desc(texture_desc desc, const uint32_t terrain_size)
+{
+  desc.size = terrain_size / 2;
+  return desc;
+}
+
+} // namespace
+
+output::output(std::shared_ptr<device> dev, const uint32_t terrain_size, texture_desc layer_desc)
   : device_(dev)
     , terrain_size_(terrain_size)
-    , rock_height_(dev->create_texture(terrain_size / 2))
-    , soil_height_(dev->create_texture(terrain_size / 2))
+    , layer_desc_(make_layer_desc(std::move(layer_desc), terrain_size))
+    , rock_height_(create_layer_texture(".rock"))
+    , soil_height_(create_layer_texture(".soil"))
+    , raise_kernel_(device_->get_kernel_registry()->raise_kernel())
 {
+  memory_.update(get_memory_usage());
 }
 
 output::~output()
 {
-  //
+  // The layers are released here rather than with the device, so that evicting outputs (such as cached chunks)
+  // gives their memory back.
+  for (auto* t : { rock_height_, soil_height_ }) {
+    if (t)
+      device_->destroy_texture(t);
+  }
+}
+
+size_t
+output::get_memory_usage() const
+{
+  size_t bytes = 0;
+
+  for (const auto* t : { rock_height_, soil_height_ }) {
+    if (t)
+      bytes += t->get_memory_usage();
+  }
+
+  return bytes;
 }
 
+const memory_stats*
+output::get_memory_stats()
+{
+  memory_.update(get_memory_usage());
+
+  return &memory_;
+}
+
+template<typename texel_func>
 bool
-output::save_height_png(const char* path, ptg_write_png png_writer)
+output::for_each_height_texel(texel_func func)
 {
-  const uint32_t total_size = terrain_size_ * terrain_size_;
+  const uint32_t texture_size = terrain_size_ / 2;
+
+  texture* const layers[] = { rock_height_, soil_height_ };
+
+  constexpr int layer_count = 2;
+
+  uint32_t tile_size = texture_size;
+
+  for (const auto* t : layers) {
+    if (t)
+      tile_size = std::min(tile_size, t->get_tile_size());
+  }
+
+  for (uint32_t ty = 0; ty < texture_size; ty += tile_size) {
+
+    for (uint32_t tx = 0; tx < texture_size; tx += tile_size) {
+
+      const glm::uvec2 origin(tx, ty);
+
+      const auto extent = glm::min(glm::uvec2(tile_size), glm::uvec2(texture_size) - origin);
 
-  std::vector<float> hdr_result(total_size, 0.0f);
+      const scratch_arena::scope scratch_scope(scratch_arena::get_thread_arena());
 
-  {
-    std::vector<float> rock_data(total_size);
+      texel_tile tiles[layer_count];
 
-    rock_height_->read_data(rock_data.data());
+      bool mapped = true;
 
-    for (uint32_t i = 0; i < total_size; i++)
-      hdr_result[i] += rock_data[i];
+      for (int i = 0; i < layer_count; i++) {
+        if (layers[i]) {
+          tiles[i] = layers[i]->map_region(origin, extent, tile_access::read_only);
+          mapped = mapped && tiles[i].data;
+        }
+      }
+
+      for (uint32_t y = origin.y; mapped && (y < (origin.y + extent.y)); y++) {
+
+        for (uint32_t x = origin.x; x < (origin.x + extent.x); x++) {
+
+          glm::vec4 height(0.0f, 0.0f, 0.0f, 0.0f);
+
+          for (const auto& tile : tiles) {
+            if (tile.data)
+              height += tile.at(glm::uvec2(x, y));
+          }
+
+          func(glm::uvec2(x, y), height);
+        }
+      }
+
+      for (int i = 0; i < layer_count; i++) {
+        if (layers[i])
+          layers[i]->unmap_region(tiles[i], tile_access::read_only);
+      }
+
+      if (!mapped)
+        return false;
+    }
   }
 
-  {
-    std::vector<float> soil_data(total_size);
+  return true;
+}
+
+void
+output::read_height(float* heights)
+{
+  // Each texel contains a 2x2 block of height values, which are unpacked into rows.
+
+  std::fill_n(heights, static_cast<size_t>(terrain_size_) * terrain_size_, 0.0f);
 
-    soil_height_->read_data(soil_data.data());
+  const bool read = for_each_height_texel([this, heights](const glm::uvec2 texel, const glm::vec4& height) {
+    const size_t dst = (static_cast<size_t>(texel.y) * 2 * terrain_size_) + (texel.x * 2);
 
-    for (uint32_t i = 0; i < total_size; i++)
-      hdr_result[i] += soil_data[i];
+    heights[dst + 0] = height[0];
+    heights[dst + 1] = height[1];
+    heights[dst + terrain_size_ + 0] = height[2];
+    heights[dst + terrain_size_ + 1] = height[3];
+  });
+
+  if (!read)
+    device_->error("Failed to read heights because a layer texture could not be mapped.");
+}
+
+bool
+output::save_height_png(const char* path, ptg_write_png png_writer)
+{
+  const trace_scope scope(device_->get_trace(), "save height png", "export");
+
+  if (!rock_height_ || !soil_height_) {
+    device_->error("Failed to save height PNG because a layer texture could not be created.");
+    return false;
   }
 
-  float min_h = hdr_result[0];
-  float max_h = hdr_result[0];
+  // The layers are read twice, tile by tile: once to find the range of heights and once to convert them. Only the
+  // 8-bit image is held in full, since the PNG writer takes the whole image at once.
+
+  float min_h = std::numeric_limits<float>::max();
+  float max_h = std::numeric_limits<float>::lowest();
+
+  const bool read = for_each_height_texel([&min_h, &max_h](glm::uvec2, const glm::vec4& height) {
+    for (int c = 0; c < 4; c++) {
+      min_h = (min_h < height[c]) ? min_h : height[c];
+      max_h = (max_h > height[c]) ? max_h : height[c];
+    }
+  });
 
-  for (uint32_t i = 1; i < total_size; i++) {
-    min_h = (min_h < hdr_result[i]) ? min_h : hdr_result[i];
-    max_h = (max_h > hdr_result[i]) ? max_h : hdr_result[i];
+  if (!read) {
+    device_->error("Failed to save height PNG because a layer texture could not be mapped.");
+    return false;
   }
 
+  const uint32_t total_size = terrain_size_ * terrain_size_;
+
   std::vector<uint8_t> ldr_result(total_size);
 
   auto clamp = [](int x) -> uint8_t {
@@ -66,40 +194,54 @@ output::save_height_png(const char* path, ptg_write_png png_writer)
 
   const float scale = 255.0f / (max_h - min_h);
 
-  for (uint32_t y = 0; y < terrain_size_; y += 2) {
+  const uint32_t texture_size = terrain_size_ / 2;
+
+  // The image keeps the layout that the export has always written: the texel data of the layers, four heights per
+  // texel, is laid out in rows of the terrain size. Even rows hold those values directly, and each odd row starts
+  // with the last two values of its own row, leaving the rest of it zero.
+
+  for_each_height_texel([&](const glm::uvec2 texel, const glm::vec4& height) {
+    for (uint32_t c = 0; c < 4; c++) {
+
+      const uint32_t i = (((texel.y * texture_size) + texel.x) * 4) + c;
 
-    for (uint32_t x = 0; x < terrain_size_; x += 2) {
+      const uint32_t row = i / terrain_size_;
 
-      const uint32_t i0 = ((y + 0) * terrain_size_) + (x + 0);
-      const uint32_t i1 = ((y + 0) * terrain_size_) + (x + 1);
-      const uint32_t i2 = ((y + 1) * terrain_size_) + (x + 0);
-      const uint32_t i3 = ((y + 1) * terrain_size_) + (x + 1);
+      const uint32_t column = i % terrain_size_;
 
-      const uint32_t dst = (y * terrain_size_) + x;
+      const auto value = clamp((height[c] - min_h) * scale);
 
-      ldr_result[dst + 0] = clamp((hdr_result[i0] - min_h) * scale);
-      ldr_result[dst + 1] = clamp((hdr_result[i1] - min_h) * scale);
-      ldr_result[dst + 2] = clamp((hdr_result[i2] - min_h) * scale);
-      ldr_result[dst + 3] = clamp((hdr_result[i3] - min_h) * scale);
+      if ((row % 2) == 0)
+        ldr_result[i] = value;
+      else if (column >= (terrain_size_ - 2))
+        ldr_result[(row * terrain_size_) + (column - (terrain_size_ - 2))] = value;
     }
-  }
+  });
 
   return png_writer(path, terrain_size_, terrain_size_, 1, ldr_result.data(), terrain_size_);
 }
 
 uint32_t
 output::prepare_bake(const model& m)
+{
+  return prepare_bake(m.copy_current_memento());
+}
+
+uint32_t
+output::prepare_bake(memento m)
 {
   if (bake_job_) {
     device_->error("Cannot prepare bake because one is already active.");
     return 0u;
   }
 
-  auto m_copy = m.copy_current_memento();
+  const auto op_count = m.operations.size();
 
-  const auto op_count = m_copy.operations.size();
+  // A model without operations has nothing to bake, so no job is started.
+  if (op_count == 0)
+    return 0u;
 
-  bake_job_ = bake_job{ std::move(m_copy) };
+  bake_job_ = bake_job{ std::move(m) };
 
   return op_count;
 }
@@ -112,6 +254,13 @@ output::iterate_bake()
     return false;
   }
 
+  if (bake_job_->operation_index >= bake_job_->m.operations.size()) {
+    bake_job_.reset();
+    return false;
+  }
+
+  const trace_scope scope(device_->get_trace(), "bake operation", "output");
+
   const auto& op = bake_job_->m.operations[bake_job_->operation_index];
 
   switch (op.kind) {
@@ -122,6 +271,8 @@ output::iterate_bake()
 
   bake_job_->operation_index++;
 
+  memory_.update(get_memory_usage());
+
   if (bake_job_->operation_index >= bake_job_->m.operations.size()) {
     device_->info("Bake operation complete.");
     bake_job_.reset();
@@ -133,52 +284,152 @@ output::iterate_bake()
 void
 output::apply_raise_operation(const path& p)
 {
-  auto* k = device_->get_kernel_registry()->raise_kernel;
+  auto* k = raise_kernel_.get();
 
   const auto work_group_size = device_->get_work_group_size();
 
   const auto meters_per_axis = bake_job_->m.meters_per_axis;
 
-  const auto brush_center_location = k->get_uniform_location("brush_center");
+  raise_params params;
 
-  const auto brush_size_location = k->get_uniform_location("brush_size");
+  params.terrain_texel_size = meters_per_axis / static_cast<float>(terrain_size_);
 
-  const auto terrain_texel_size_location = k->get_uniform_location("terrain_texel_size");
+  params.terrain_origin = origin_;
 
-  const auto input_texture_location = k->get_uniform_location("input_texture");
+  params.brush_size = p.brush_size;
 
-  const auto output_texture_location = k->get_uniform_location("output_texture");
+  params.brush_radius = p.brush_radius;
 
-  k->set_uniform_float(terrain_texel_size_location, meters_per_axis / static_cast<float>(terrain_size_));
+  const bool in_place = k->supports_in_place();
 
-  k->set_uniform_float(brush_size_location, p.brush_size);
+  // A mapped layer is bound to its file, so it cannot be replaced by a new texture.
+  if (!in_place && (layer_desc_.storage == texture_storage::mapped)) {
+    device_->error("Failed to apply raise operation because mapped layers can only be updated in place.");
+    return;
+  }
 
-  for (uint32_t i = 0; i < p.xy_coordinates.size(); i += 2) {
+  if (p.xy_coordinates.size() < 2)
+    return;
 
-    auto* input_texture = get_layer_texture(p.layer);
+  // Every point of the path is applied in a single dispatch, with the points passed through a buffer.
 
-    auto* output_texture = device_->create_texture(input_texture->get_size());
+  const auto point_data_size = (p.xy_coordinates.size() / 2) * sizeof(glm::vec2);
 
-    k->set_active_texture(0, input_texture);
-    k->set_active_texture(1, output_texture);
+  auto* points = device_->create_buffer(point_data_size);
+  if (!points) {
+    device_->error("Failed to apply raise operation because the path buffer could not be created.");
+    return;
+  }
+
+  std::memcpy(points->map(), p.xy_coordinates.data(), point_data_size);
 
-    k->set_uniform_int(input_texture_location, 0);
-    k->set_uniform_int(output_texture_location, 1);
+  points->unmap();
 
-    const auto x = p.xy_coordinates[i + 0];
-    const auto y = p.xy_coordinates[i + 1];
+  // When updating in place, both textures refer to the same texture unit, so it is mapped once for reading and
+  // writing.
+  params.input_texture = 0;
+  params.output_texture = in_place ? 0 : 1;
+  params.brush_buffer = 0;
 
-    k->set_uniform_vec2(brush_center_location, glm::vec2{ x, y });
+  auto* input_texture = get_layer_texture(p.layer);
 
-    const uint32_t work_group_count_x = terrain_size_ / (work_group_size.x * 2u);
-    const uint32_t work_group_count_y = terrain_size_ / (work_group_size.y * 2u);
+  auto* output_texture = in_place ? input_texture : device_->create_texture(layer_desc_);
 
-    k->dispatch(glm::uvec2{ work_group_count_x, work_group_count_y });
+  if (!input_texture || !output_texture) {
+    device_->error("Failed to apply raise operation because a layer texture could not be created.");
+    if (!in_place && output_texture)
+      device_->destroy_texture(output_texture);
+    device_->destroy_buffer(points);
+    return;
+  }
 
-    set_layer_texture(p.layer, output_texture);
+  if (!in_place)
+    memory_.record_allocation();
 
-    device_->destroy_texture(input_texture);
+  if (!k->set_params(params)) {
+    device_->error("Failed to apply raise operation because the kernel does not accept raise parameters.");
+    if (!in_place)
+      device_->destroy_texture(output_texture);
+    device_->destroy_buffer(points);
+    return;
   }
+
+  k->set_active_texture(0, input_texture);
+  k->set_active_texture(1, in_place ? nullptr : output_texture);
+  k->set_buffer(0, points);
+
+  const uint32_t work_group_count_x = terrain_size_ / (work_group_size.x * 2u);
+  const uint32_t work_group_count_y = terrain_size_ / (work_group_size.y * 2u);
+
+  const glm::uvec2 work_group_bounds{ work_group_count_x, work_group_count_y };
+
+  glm::uvec2 wg_min{ 0, 0 };
+
+  glm::uvec2 wg_max{ work_group_bounds };
+
+  // A bounded brush only changes the texels within its radius. When updating in place, the rest of the layer can
+  // be left out of the dispatch entirely. (A new texture has to be written in full.)
+  if (in_place && (p.brush_radius > 0.0f)) {
+
+    glm::vec2 lo{ p.xy_coordinates[0], p.xy_coordinates[1] };
+
+    glm::vec2 hi{ lo };
+
+    for (size_t i = 2; (i + 1) < p.xy_coordinates.size(); i += 2) {
+      const glm::vec2 point{ p.xy_coordinates[i], p.xy_coordinates[i + 1] };
+      lo = glm::min(lo, point);
+      hi = glm::max(hi, point);
+    }
+
+    // This inverts the texel positions computed by the kernel, with a texel of margin for rounding.
+
+    const auto texel_scale = 1.0f / (2.0f * params.terrain_texel_size);
+
+    const auto texel_min = glm::floor((lo - origin_ - p.brush_radius - 1.0f) * texel_scale) - 1.0f;
+
+    const auto texel_max = glm::floor((hi - origin_ + p.brush_radius) * texel_scale) + 1.0f;
+
+    const auto bounds = glm::vec2(work_group_bounds);
+
+    const auto wg_size = glm::vec2(work_group_size);
+
+    wg_min = glm::uvec2(glm::clamp(glm::floor(texel_min / wg_size), glm::vec2(0.0f), bounds));
+
+    wg_max = glm::uvec2(glm::clamp(glm::floor(texel_max / wg_size) + 1.0f, glm::vec2(0.0f), bounds));
+  }
+
+  if ((wg_min.x < wg_max.x) && (wg_min.y < wg_max.y))
+    k->dispatch(wg_min, wg_max - wg_min, work_group_bounds);
+
+  k->set_buffer(0, nullptr);
+
+  device_->destroy_buffer(points);
+
+  if (in_place)
+    return;
+
+  set_layer_texture(p.layer, output_texture);
+
+  device_->destroy_texture(input_texture);
+}
+
+texture*
+output::create_layer_texture(const char* path_suffix)
+{
+  texture* t = nullptr;
+
+  if (layer_desc_.storage != texture_storage::mapped) {
+    t = device_->create_texture(layer_desc_);
+  } else {
+    // Each layer gets its own file, named after the path given for the output.
+    const auto path = layer_desc_.path + path_suffix;
+    t = device_->create_mapped_texture(path.c_str(), layer_desc_.size, layer_desc_.map_flags);
+  }
+
+  if (t)
+    memory_.record_allocation();
+
+  return t;
 }
 
 texture*
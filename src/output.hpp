@@ -1,6 +1,8 @@
 #pragma once
 
 #include "device.hpp"
+#include "device_stats.hpp"
+#include "kernel.hpp"
 #include "model.hpp"
 #include "texture.hpp"
 
@@ -14,7 +16,14 @@ namespace ptg {
 class output final
 {
 public:
-  explicit output(std::shared_ptr<device> dev, const uint32_t terrain_size);
+  /// @brief Constructs a new output.
+  ///
+  /// @param dev The device to create the layer textures with.
+  ///
+  /// @param terrain_size The size of the terrain, in cells per axis.
+  ///
+  /// @param layer_desc Describes how the layer textures are stored. The size field is ignored.
+  explicit output(std::shared_ptr<device> dev, uint32_t terrain_size, texture_desc layer_desc = texture_desc{});
 
   output(const output&) = delete;
 
@@ -31,6 +40,36 @@ public:
   /// @return The size of the terrain, in both axes.
   uint32_t get_terrain_size() const { return terrain_size_; }
 
+  /// @brief Sets the position of the terrain's first texel in world space, in meters.
+  ///        Model operations are evaluated relative to this point, which allows several outputs to be baked as
+  ///        adjacent pieces of one larger terrain.
+  ///
+  /// @param origin The origin of the terrain, in meters.
+  void set_origin(const glm::vec2& origin) { origin_ = origin; }
+
+  /// @brief Gets the position of the terrain's first texel in world space.
+  ///
+  /// @return The origin of the terrain, in meters.
+  [[nodiscard]] glm::vec2 get_origin() const { return origin_; }
+
+  /// @brief Gets the number of bytes used by the layer textures of the output.
+  ///
+  /// @return The number of bytes used by the layer textures.
+  [[nodiscard]] size_t get_memory_usage() const;
+
+  /// @brief Gets the memory held by the layer textures of the output.
+  ///        The live bytes (and the peak, if exceeded) are brought up to date before returning.
+  ///
+  /// @return The memory counters of the output.
+  const memory_stats* get_memory_stats();
+
+  /// @brief Reads the total height (the sum of all layers) of each cell in the terrain.
+  ///        The layers are read one tile at a time, so no copy of a whole layer is made.
+  ///
+  /// @param heights The array to write the heights to.
+  ///                It must have room for the terrain size squared, and is written in row-major order.
+  void read_height(float* heights);
+
   /// @brief Saves the total height of each cell in a PNG file.
   /// @param path The path to save the PNG file to.
   /// @param png_writer Used to serialize the PNG data.
@@ -44,14 +83,32 @@ public:
   /// @return The number of steps required to bake the output.
   uint32_t prepare_bake(const model& m);
 
+  /// @brief Prepares to bake a snapshot of a model.
+  ///
+  /// @param m The memento to bake.
+  ///
+  /// @return The number of steps required to bake the output.
+  ///         If the snapshot has no operations, this is zero and no bake job is started.
+  uint32_t prepare_bake(memento m);
+
   /// @brief Iterates the bake operation.
   ///
   /// @return True on success, false if the bake is done.
   bool iterate_bake();
 
+  /// @brief Indicates whether a bake job has been prepared and still has steps left to take.
+  [[nodiscard]] bool has_bake_job() const { return bake_job_.has_value(); }
+
 private:
   void apply_raise_operation(const path& p);
 
+  /// @brief Creates the texture for a layer of the output.
+  ///
+  /// @param path_suffix Appended to the path of mapped layers, so that each layer has its own file.
+  ///
+  /// @return The new layer texture.
+  texture* create_layer_texture(const char* path_suffix);
+
   /// @brief Gets a texture associated with a specific layer.
   ///
   /// @param layer The layer to get the texture of.
@@ -66,6 +123,15 @@ private:
   /// @param t The texture to assign the layer.
   void set_layer_texture(PtgLayer layer, texture* t);
 
+  /// @brief Calls a function with the total height of each texel of the layers, mapping one tile at a time.
+  ///        Layers that could not be created contribute nothing.
+  ///
+  /// @param func Called with the position of each texel and the sum of the layers at it.
+  ///
+  /// @return True if every tile was read, false if a tile of a layer could not be mapped.
+  template<typename texel_func>
+  bool for_each_height_texel(texel_func func);
+
   /// @brief Used to store data related to a bake job.
   struct bake_job final
   {
@@ -82,12 +148,24 @@ private:
   /// The size of the terrain in each axis.
   uint32_t terrain_size_{ 0 };
 
-  /// The rock layer height texture.
+  /// The position of the first texel in world space, in meters.
+  glm::vec2 origin_{ 0, 0 };
+
+  /// Describes how the layer textures are stored.
+  texture_desc layer_desc_;
+
+  /// The memory held by the layer textures. This is declared before them, since creating them counts allocations.
+  memory_stats memory_;
+
+  /// The rock layer height texture, which is null if it could not be created.
   texture* rock_height_;
 
-  /// The soil layer height texture.
+  /// The soil layer height texture, which is null if it could not be created.
   texture* soil_height_;
 
+  /// The raise kernel instance of this output, which holds its parameters and bindings.
+  std::unique_ptr<kernel> raise_kernel_;
+
   std::optional<bake_job> bake_job_;
 };
 
@@ -0,0 +1,194 @@
+#include "packed_texture.hpp"
+
+#include <cmath>
+#include <cstring>
+
+namespace ptg {
+
+namespace {
+
+// The half precision conversions round to nearest even and handle denormals, infinity and NaN.
+// They are done with integer arithmetic so that they do not depend on F16C or similar instructions.
+
+uint16_t
+float_to_half(const float value)
+{
+  constexpr uint32_t f32_infinity = 255u << 23;
+  constexpr uint32_t f16_max = (127u + 16u) << 23;
+  constexpr uint32_t denorm_magic_bits = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+  uint32_t f = 0;
+  std::memcpy(&f, &value, sizeof(f));
+
+  const uint32_t sign = f & 0x80000000u;
+
+  f ^= sign;
+
+  uint16_t result = 0;
+
+  if (f >= f16_max) {
+    result = (f > f32_infinity) ? 0x7e00 : 0x7c00;
+  } else if (f < (113u << 23)) {
+    // Adding the magic number shifts the mantissa into place, with the FPU doing the rounding.
+    float magic = 0;
+    std::memcpy(&magic, &denorm_magic_bits, sizeof(magic));
+    float tmp = 0;
+    std::memcpy(&tmp, &f, sizeof(tmp));
+    tmp += magic;
+    std::memcpy(&f, &tmp, sizeof(f));
+    result = static_cast<uint16_t>(f - denorm_magic_bits);
+  } else {
+    const uint32_t mantissa_odd = (f >> 13) & 1u;
+    f += (static_cast<uint32_t>(15 - 127) << 23) + 0xfffu;
+    f += mantissa_odd;
+    result = static_cast<uint16_t>(f >> 13);
+  }
+
+  return result | static_cast<uint16_t>(sign >> 16);
+}
+
+float
+half_to_float(const uint16_t value)
+{
+  constexpr uint32_t shifted_exponent = 0x7c00u << 13;
+  constexpr uint32_t denorm_magic_bits = 113u << 23;
+
+  uint32_t bits = (value & 0x7fffu) << 13;
+
+  const uint32_t exponent = shifted_exponent & bits;
+
+  bits += (127u - 15u) << 23;
+
+  if (exponent == shifted_exponent) {
+    bits += (128u - 16u) << 23;
+  } else if (exponent == 0) {
+    bits += 1u << 23;
+    float magic = 0;
+    std::memcpy(&magic, &denorm_magic_bits, sizeof(magic));
+    float tmp = 0;
+    std::memcpy(&tmp, &bits, sizeof(tmp));
+    tmp -= magic;
+    std::memcpy(&bits, &tmp, sizeof(bits));
+  }
+
+  bits |= static_cast<uint32_t>(value & 0x8000u) << 16;
+
+  float result = 0;
+  std::memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+} // namespace
+
+packed_texture::packed_texture(const uint32_t size,
+                               const texel_format format,
+                               const float scale,
+                               const float offset,
+                               std::shared_ptr<memory_allocator> allocator)
+  : size_(size)
+    , format_(format)
+    , scale_(scale)
+    , offset_(offset)
+    , data_(static_cast<size_t>(size) * size * 4, 0, texel_allocator<uint16_t>(std::move(allocator)))
+{
+  // Zero has to decode as zero, which is not the case for unsigned normalized formats with an offset.
+  if (format_ == texel_format::rgba16_unorm) {
+    const glm::vec4 zero_texel(0.0f);
+    uint16_t zero[4];
+    encode(&zero_texel, zero, 1);
+    for (size_t i = 0; i < data_.size(); i += 4)
+      std::memcpy(&data_[i], zero, sizeof(zero));
+  }
+}
+
+void
+packed_texture::read_data(float* data)
+{
+  decode(data_.data(), reinterpret_cast<glm::vec4*>(data), static_cast<size_t>(size_) * size_);
+}
+
+texture_desc
+packed_texture::get_desc() const
+{
+  texture_desc desc;
+  desc.size = size_;
+  desc.format = format_;
+  desc.format_scale = scale_;
+  desc.format_offset = offset_;
+  return desc;
+}
+
+texel_tile
+packed_texture::map_region(const glm::uvec2 origin, const glm::uvec2 size, const tile_access access)
+{
+  // The decoded texels live in the scratch arena of the calling thread, whose memory is reused from one tile to the
+  // next, so mapping a region does not allocate once the arena has grown to the size of a tile.
+  auto* texels = scratch_arena::get_thread_arena().allocate_array<glm::vec4>(static_cast<size_t>(size.x) * size.y);
+
+  if (access != tile_access::write_only) {
+    for (uint32_t y = 0; y < size.y; y++) {
+      const auto src_offset = ((static_cast<size_t>(origin.y + y) * size_) + origin.x) * 4;
+      decode(&data_[src_offset], &texels[y * size.x], size.x);
+    }
+  }
+
+  return texel_tile{ texels, origin, size, size.x };
+}
+
+void
+packed_texture::unmap_region(const texel_tile& tile, const tile_access access)
+{
+  if (access != tile_access::read_only) {
+    for (uint32_t y = 0; y < tile.size.y; y++) {
+      const auto dst_offset = ((static_cast<size_t>(tile.origin.y + y) * size_) + tile.origin.x) * 4;
+      encode(&tile.data[y * tile.pitch], &data_[dst_offset], tile.size.x);
+    }
+  }
+}
+
+void
+packed_texture::decode(const uint16_t* src, glm::vec4* dst, const size_t count) const
+{
+  if (format_ == texel_format::rgba16f) {
+    for (size_t i = 0; i < count; i++) {
+      dst[i] = glm::vec4(half_to_float(src[(i * 4) + 0]),
+                         half_to_float(src[(i * 4) + 1]),
+                         half_to_float(src[(i * 4) + 2]),
+                         half_to_float(src[(i * 4) + 3]));
+    }
+    return;
+  }
+
+  const float step = scale_ / 65535.0f;
+
+  for (size_t i = 0; i < count; i++) {
+    const glm::vec4 encoded(src[(i * 4) + 0], src[(i * 4) + 1], src[(i * 4) + 2], src[(i * 4) + 3]);
+    dst[i] = (encoded * step) + glm::vec4(offset_);
+  }
+}
+
+void
+packed_texture::encode(const glm::vec4* src, uint16_t* dst, const size_t count) const
+{
+  if (format_ == texel_format::rgba16f) {
+    for (size_t i = 0; i < count; i++) {
+      dst[(i * 4) + 0] = float_to_half(src[i].x);
+      dst[(i * 4) + 1] = float_to_half(src[i].y);
+      dst[(i * 4) + 2] = float_to_half(src[i].z);
+      dst[(i * 4) + 3] = float_to_half(src[i].w);
+    }
+    return;
+  }
+
+  const float inv_step = 65535.0f / scale_;
+
+  for (size_t i = 0; i < count; i++) {
+    const auto normalized = glm::clamp((src[i] - glm::vec4(offset_)) * inv_step, 0.0f, 65535.0f);
+    dst[(i * 4) + 0] = static_cast<uint16_t>(normalized.x + 0.5f);
+    dst[(i * 4) + 1] = static_cast<uint16_t>(normalized.y + 0.5f);
+    dst[(i * 4) + 2] = static_cast<uint16_t>(normalized.z + 0.5f);
+    dst[(i * 4) + 3] = static_cast<uint16_t>(normalized.w + 0.5f);
+  }
+}
+
+} // namespace ptg
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "texel_allocator.hpp"
+#include "texture.hpp"
+
+#include <vector>
+
+namespace ptg {
+
+/// @brief A texture that stores each channel in 16 bits, instead of a full 32-bit float.
+///        Mapped regions are decoded into 32-bit floats in the scratch arena of the calling thread, and encoded again
+///        when they are unmapped after writing, so kernels are unaware of the storage format.
+class packed_texture final : public texture
+{
+public:
+  /// @brief The size of the tiles that kernels process this texture in.
+  static constexpr uint32_t tile_size() { return 64; }
+
+  /// @brief Constructs a new packed texture, where every texel is zero.
+  ///
+  /// @param size The size of the texture, in both axes.
+  ///
+  /// @param format The format to store the texels in. This must be a 16-bit format.
+  ///
+  /// @param scale For unsigned normalized formats, the value that the largest encoded value maps to (before the
+  ///              offset is added).
+  ///
+  /// @param offset For unsigned normalized formats, the value that zero maps to.
+  ///
+  /// @param allocator The allocator to allocate the encoded texels with.
+  packed_texture(uint32_t size,
+                 texel_format format,
+                 float scale,
+                 float offset,
+                 std::shared_ptr<memory_allocator> allocator = get_default_allocator());
+
+  void read_data(float* data) override;
+
+  [[nodiscard]] uint32_t get_size() const override { return size_; }
+
+  [[nodiscard]] texture_desc get_desc() const override;
+
+  [[nodiscard]] size_t get_memory_usage() const override { return data_.size() * sizeof(uint16_t); }
+
+  [[nodiscard]] uint32_t get_tile_size() const override { return tile_size(); }
+
+  texel_tile map_region(glm::uvec2 origin, glm::uvec2 size, tile_access access) override;
+
+  void unmap_region(const texel_tile& tile, tile_access access) override;
+
+  void* get_data_pointer() override { return nullptr; }
+
+  [[nodiscard]] const void* get_data_pointer() const override { return nullptr; }
+
+private:
+  /// @brief Decodes a run of texels.
+  void decode(const uint16_t* src, glm::vec4* dst, size_t count) const;
+
+  /// @brief Encodes a run of texels.
+  void encode(const glm::vec4* src, uint16_t* dst, size_t count) const;
+
+  const uint32_t size_{ 0 };
+
+  const texel_format format_{ texel_format::rgba16f };
+
+  const float scale_{ 1.0f };
+
+  const float offset_{ 0.0f };
+
+  /// @brief The encoded texels, with four channels per texel.
+  std::vector<uint16_t, texel_allocator<uint16_t>> data_;
+};
+
+} // namespace ptg
@@ -0,0 +1,468 @@
+#include "paged_texture.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace ptg {
+
+namespace {
+
+constexpr size_t tile_bytes = paged_texture::tile_size() * paged_texture::tile_size() * sizeof(glm::vec4);
+
+} // namespace
+
+void
+page_cache::texel_deleter::operator()(glm::vec4* texels) const
+{
+  allocator->deallocate(texels, tile_bytes);
+}
+
+page_cache::page_cache(const size_t memory_budget, std::string directory, std::shared_ptr<memory_allocator> allocator)
+  : memory_budget_(memory_budget)
+    , directory_(std::move(directory))
+    , allocator_(std::move(allocator))
+{
+}
+
+glm::vec4*
+page_cache::acquire(paged_texture* owner, const uint32_t tile_index, const bool load)
+{
+  const page_key key{ owner, tile_index };
+
+  std::unique_lock<std::mutex> lock(lock_);
+
+  // Returns the page if it is loaded, waiting for it if it is busy.
+  auto find_loaded = [this, &key, &lock]() {
+    auto it = pages_.find(key);
+    while ((it != pages_.end()) && it->second.busy) {
+      io_done_.wait(lock);
+      it = pages_.find(key);
+    }
+    return it;
+  };
+
+  auto it = find_loaded();
+
+  if (it == pages_.end()) {
+
+    lock.unlock();
+
+    // The texels are allocated outside of the lock, since making room for them in the memory budget of the device
+    // may trim this cache.
+
+    texel_ptr texels(static_cast<glm::vec4*>(allocator_->allocate(tile_bytes, texel_alignment)),
+                     texel_deleter{ allocator_.get() });
+    if (!texels)
+      return nullptr;
+
+    lock.lock();
+
+    // Another thread may have loaded the tile in the meantime, in which case the new texels are not needed.
+    it = find_loaded();
+
+    if (it == pages_.end()) {
+
+      auto write_backs = evict(tile_bytes);
+
+      page p;
+
+      p.texels = std::move(texels);
+
+      p.pin_count = 1;
+
+      p.busy = true;
+
+      lru_.emplace_front(key);
+
+      p.lru_position = lru_.begin();
+
+      it = pages_.emplace(key, std::move(p)).first;
+
+      memory_usage_ += tile_bytes;
+
+      owner->resident_bytes_.fetch_add(tile_bytes, std::memory_order_relaxed);
+
+      // The page is pinned and busy, so it stays put and is not handed out while it is filled in outside of the lock.
+
+      auto* data = it->second.texels.get();
+
+      lock.unlock();
+
+      write_back(write_backs);
+
+      if (load)
+        owner->read_tile(tile_index, data);
+      else
+        std::fill_n(data, tile_bytes / sizeof(glm::vec4), glm::vec4(0.0f));
+
+      lock.lock();
+
+      it->second.busy = false;
+
+      lock.unlock();
+
+      io_done_.notify_all();
+
+      return data;
+    }
+  }
+
+  lru_.splice(lru_.begin(), lru_, it->second.lru_position);
+
+  it->second.pin_count++;
+
+  return it->second.texels.get();
+}
+
+void
+page_cache::release(paged_texture* owner, const uint32_t tile_index, const bool modified)
+{
+  write_back_list write_backs;
+
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+
+    auto it = pages_.find(page_key{ owner, tile_index });
+    if (it == pages_.end())
+      return;
+
+    it->second.pin_count--;
+
+    it->second.dirty |= modified;
+
+    write_backs = evict(0);
+  }
+
+  write_back(write_backs);
+}
+
+void
+page_cache::discard(paged_texture* owner)
+{
+  std::unique_lock<std::mutex> lock(lock_);
+
+  auto is_busy = [this, owner]() {
+    for (auto it = pages_.lower_bound(page_key{ owner, 0 }); (it != pages_.end()) && (it->first.first == owner); ++it) {
+      if (it->second.busy)
+        return true;
+    }
+    return false;
+  };
+
+  io_done_.wait(lock, [&is_busy]() { return !is_busy(); });
+
+  auto it = pages_.lower_bound(page_key{ owner, 0 });
+
+  while ((it != pages_.end()) && (it->first.first == owner)) {
+    lru_.erase(it->second.lru_position);
+    memory_usage_ -= tile_bytes;
+    owner->resident_bytes_.fetch_sub(tile_bytes, std::memory_order_relaxed);
+    it = pages_.erase(it);
+  }
+}
+
+size_t
+page_cache::trim()
+{
+  size_t released = 0;
+
+  write_back_list write_backs;
+
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+
+    const auto old_usage = memory_usage_;
+
+    write_backs = evict_until(0);
+
+    released = old_usage - memory_usage_;
+  }
+
+  write_back(write_backs);
+
+  return released;
+}
+
+page_cache::write_back_list
+page_cache::evict(const size_t incoming_bytes)
+{
+  return evict_until((memory_budget_ > incoming_bytes) ? (memory_budget_ - incoming_bytes) : 0);
+}
+
+page_cache::write_back_list
+page_cache::evict_until(const size_t limit)
+{
+  write_back_list write_backs;
+
+  // Walk from the least recently used page, skipping over pages that are still mapped.
+
+  auto it = lru_.end();
+
+  while ((memory_usage_ > limit) && (it != lru_.begin())) {
+
+    --it;
+
+    auto page_it = pages_.find(*it);
+
+    auto& p = page_it->second;
+
+    if ((p.pin_count > 0) || p.busy)
+      continue;
+
+    memory_usage_ -= tile_bytes;
+
+    it = lru_.erase(it);
+
+    if (p.dirty) {
+      p.busy = true;
+      write_backs.emplace_back(page_it->first, &p);
+      continue;
+    }
+
+    erase_page(page_it);
+  }
+
+  return write_backs;
+}
+
+void
+page_cache::write_back(const write_back_list& pages)
+{
+  if (pages.empty())
+    return;
+
+  // Busy pages are neither released nor handed out by other threads, so they can be read here without the lock.
+  for (const auto& entry : pages)
+    entry.first.first->write_tile(entry.first.second, entry.second->texels.get());
+
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+
+    for (const auto& entry : pages)
+      erase_page(pages_.find(entry.first));
+  }
+
+  io_done_.notify_all();
+}
+
+void
+page_cache::erase_page(const std::map<page_key, page>::iterator it)
+{
+  it->first.first->resident_bytes_.fetch_sub(tile_bytes, std::memory_order_relaxed);
+
+  pages_.erase(it);
+}
+
+std::unique_ptr<paged_texture>
+paged_texture::create(const uint32_t size, std::shared_ptr<page_cache> cache, error_func on_error)
+{
+  std::string path = cache->get_directory();
+
+  if (path.empty()) {
+    const char* tmp_dir = std::getenv("TMPDIR");
+    path = tmp_dir ? tmp_dir : "/tmp";
+  }
+
+  path += "/ptg-texture-XXXXXX";
+
+  const int fd = mkstemp(&path[0]);
+  if (fd < 0)
+    return nullptr;
+
+  // The file is only ever accessed through this descriptor, so it can be unlinked right away.
+  // This guarantees the file is removed, even if the process exits abnormally.
+  unlink(path.c_str());
+
+  const uint32_t tiles_per_axis = (size + tile_size() - 1) / tile_size();
+
+  const auto file_size = static_cast<off_t>(tiles_per_axis) * static_cast<off_t>(tiles_per_axis) * tile_bytes;
+
+  if (ftruncate(fd, file_size) != 0) {
+    close(fd);
+    return nullptr;
+  }
+
+  return std::unique_ptr<paged_texture>(new paged_texture(size, std::move(cache), fd, std::move(on_error)));
+}
+
+paged_texture::paged_texture(const uint32_t size,
+                             std::shared_ptr<page_cache> cache,
+                             const int file_descriptor,
+                             error_func on_error)
+  : size_(size)
+    , tiles_per_axis_((size + tile_size() - 1) / tile_size())
+    , cache_(std::move(cache))
+    , file_descriptor_(file_descriptor)
+    , on_error_(std::move(on_error))
+{
+}
+
+paged_texture::~paged_texture()
+{
+  cache_->discard(this);
+
+  close(file_descriptor_);
+}
+
+void
+paged_texture::read_data(float* data)
+{
+  // Tiles are visited in the order they are stored, which keeps reads from the file sequential.
+
+  for (uint32_t ty = 0; ty < tiles_per_axis_; ty++) {
+
+    for (uint32_t tx = 0; tx < tiles_per_axis_; tx++) {
+
+      const glm::uvec2 origin(tx * tile_size(), ty * tile_size());
+
+      const auto extent = glm::min(glm::uvec2(tile_size()), glm::uvec2(size_) - origin);
+
+      const auto tile = map_region(origin, extent, tile_access::read_only);
+      if (!tile.data)
+        continue;
+
+      for (uint32_t y = 0; y < extent.y; y++) {
+        const auto* src = &tile.data[y * tile.pitch];
+        auto* dst = &data[(((origin.y + y) * size_) + origin.x) * 4];
+        std::memcpy(dst, src, extent.x * sizeof(glm::vec4));
+      }
+
+      unmap_region(tile, tile_access::read_only);
+    }
+  }
+}
+
+texture_desc
+paged_texture::get_desc() const
+{
+  texture_desc desc;
+  desc.size = size_;
+  desc.storage = texture_storage::paged;
+  desc.cache = cache_;
+  return desc;
+}
+
+texel_tile
+paged_texture::map_region(const glm::uvec2 origin, const glm::uvec2 size, const tile_access access)
+{
+  const auto tile_pos = origin / tile_size();
+
+  const auto tile_origin = tile_pos * tile_size();
+
+  const auto tile_index = (tile_pos.y * tiles_per_axis_) + tile_pos.x;
+
+  // A tile only skips loading if every texel of it is about to be overwritten.
+  const auto full_tile = glm::min(glm::uvec2(tile_size()), glm::uvec2(size_) - tile_origin);
+
+  const bool load = (access != tile_access::write_only) || (origin != tile_origin) || (size != full_tile);
+
+  if (has_failed())
+    return texel_tile{};
+
+  auto* texels = cache_->acquire(this, tile_index, load);
+  if (!texels)
+    return texel_tile{};
+
+  // The tile may have failed to load, in which case its texels are not the contents of the texture.
+  if (has_failed()) {
+    cache_->release(this, tile_index, false);
+    return texel_tile{};
+  }
+
+  const auto offset = origin - tile_origin;
+
+  return texel_tile{ texels + (offset.y * tile_size()) + offset.x, origin, size, tile_size() };
+}
+
+void
+paged_texture::unmap_region(const texel_tile& tile, const tile_access access)
+{
+  if (!tile.data)
+    return;
+
+  const auto tile_pos = tile.origin / tile_size();
+
+  const auto tile_index = (tile_pos.y * tiles_per_axis_) + tile_pos.x;
+
+  cache_->release(this, tile_index, access != tile_access::read_only);
+}
+
+bool
+paged_texture::read_tile(const uint32_t tile_index, glm::vec4* texels)
+{
+  auto* dst = reinterpret_cast<char*>(texels);
+
+  const auto offset = static_cast<off_t>(tile_index) * static_cast<off_t>(tile_bytes);
+
+  size_t read_size = 0;
+
+  while (read_size < tile_bytes) {
+
+    const auto result = pread(file_descriptor_, dst + read_size, tile_bytes - read_size, offset + read_size);
+
+    if ((result < 0) && (errno == EINTR))
+      continue;
+
+    // The file is sized to hold every tile up front, so reaching its end early is an error too.
+    if (result <= 0)
+      break;
+
+    read_size += static_cast<size_t>(result);
+  }
+
+  if (read_size == tile_bytes)
+    return true;
+
+  std::memset(dst + read_size, 0, tile_bytes - read_size);
+
+  fail("Failed to read a tile of a paged texture from its backing file.");
+
+  return false;
+}
+
+bool
+paged_texture::write_tile(const uint32_t tile_index, const glm::vec4* texels)
+{
+  const auto* src = reinterpret_cast<const char*>(texels);
+
+  const auto offset = static_cast<off_t>(tile_index) * static_cast<off_t>(tile_bytes);
+
+  size_t write_size = 0;
+
+  while (write_size < tile_bytes) {
+
+    const auto result = pwrite(file_descriptor_, src + write_size, tile_bytes - write_size, offset + write_size);
+
+    if ((result < 0) && (errno == EINTR))
+      continue;
+
+    if (result <= 0)
+      break;
+
+    write_size += static_cast<size_t>(result);
+  }
+
+  if (write_size == tile_bytes)
+    return true;
+
+  fail("Failed to write a tile of a paged texture to its backing file.");
+
+  return false;
+}
+
+void
+paged_texture::fail(const char* msg)
+{
+  failed_.store(true, std::memory_order_relaxed);
+
+  if (on_error_)
+    on_error_(msg);
+}
+
+} // namespace ptg
@@ -0,0 +1,258 @@
+#pragma once
+
+#include "texel_allocator.hpp"
+#include "texture.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ptg {
+
+class paged_texture;
+
+/// @brief Keeps a bounded number of tiles from paged textures in memory.
+///        Tiles that are not mapped are written back to their file and released, least recently used first, once
+///        the memory budget is exceeded.
+///
+/// @details Tiles are claimed and released under the lock of the cache, but read from and written back to their
+///          files outside of it, so that threads mapping tiles that are already loaded do not wait for the disk. A
+///          tile that is being read or written back is marked as busy, and threads that need it wait until it is not.
+class page_cache final
+{
+public:
+  /// @brief Constructs a new page cache.
+  ///
+  /// @param memory_budget The maximum number of bytes of tiles to keep in memory.
+  ///                      Tiles that are currently mapped are never released, so this may be exceeded temporarily.
+  ///
+  /// @param directory The directory to create the backing files in.
+  ///                  If this is empty, the system temporary directory is used.
+  ///
+  /// @param allocator The allocator to allocate the texels of loaded tiles with.
+  page_cache(size_t memory_budget,
+             std::string directory,
+             std::shared_ptr<memory_allocator> allocator = get_default_allocator());
+
+  page_cache(const page_cache&) = delete;
+
+  page_cache(page_cache&&) = delete;
+
+  page_cache& operator=(const page_cache&) = delete;
+
+  page_cache& operator=(page_cache&&) = delete;
+
+  ~page_cache() = default;
+
+  /// @brief Gets the directory that backing files are created in.
+  [[nodiscard]] const std::string& get_directory() const { return directory_; }
+
+  /// @brief Loads a tile into memory, if it is not already, and pins it there.
+  ///
+  /// @param owner The texture that the tile belongs to.
+  ///
+  /// @param tile_index The index of the tile within the texture.
+  ///
+  /// @param load Whether or not the existing contents of the tile need to be read from the file.
+  ///
+  /// @return A pointer to the texels of the tile, or a null pointer if memory for the tile could not be allocated.
+  glm::vec4* acquire(paged_texture* owner, uint32_t tile_index, bool load);
+
+  /// @brief Unpins a tile that was loaded with @ref page_cache::acquire.
+  ///
+  /// @param owner The texture that the tile belongs to.
+  ///
+  /// @param tile_index The index of the tile within the texture.
+  ///
+  /// @param modified Whether or not the tile was written to, in which case it is written back before release.
+  void release(paged_texture* owner, uint32_t tile_index, bool modified);
+
+  /// @brief Releases all tiles of a texture without writing them back.
+  ///        Called when a texture is destroyed. Tiles of the texture that are being written back are waited for.
+  ///
+  /// @param owner The texture to release the tiles of.
+  void discard(paged_texture* owner);
+
+  /// @brief Writes back and releases every tile that is not currently mapped, regardless of the memory budget.
+  ///        Used to make room when a device runs short of memory.
+  ///
+  /// @return The number of bytes released.
+  size_t trim();
+
+private:
+  using page_key = std::pair<paged_texture*, uint32_t>;
+
+  /// @brief Frees the texels of a page through the allocator of the cache.
+  struct texel_deleter final
+  {
+    memory_allocator* allocator;
+
+    void operator()(glm::vec4* texels) const;
+  };
+
+  using texel_ptr = std::unique_ptr<glm::vec4[], texel_deleter>;
+
+  /// @brief A tile that is loaded into memory.
+  struct page final
+  {
+    /// @brief The texels of the tile.
+    texel_ptr texels;
+
+    /// @brief The number of times the page is currently mapped.
+    uint32_t pin_count{ 0 };
+
+    /// @brief Whether or not the texels differ from what is stored in the file.
+    bool dirty{ false };
+
+    /// @brief Whether the texels are being read from or written back to the file, outside of the lock.
+    bool busy{ false };
+
+    /// @brief The position of the page in the list of recently used pages. Pages being written back have already
+    ///        been removed from the list.
+    std::list<page_key>::iterator lru_position;
+  };
+
+  /// @brief A page that has been evicted, but still has to be written back before it is released.
+  using write_back_list = std::vector<std::pair<page_key, page*>>;
+
+  /// @brief Releases unpinned pages until the memory usage fits in the budget.
+  ///        The caller must hold the lock, and pass the returned pages to @ref page_cache::write_back after
+  ///        releasing it.
+  ///
+  /// @param incoming_bytes The number of bytes about to be loaded.
+  ///
+  /// @return The evicted pages that are dirty.
+  [[nodiscard]] write_back_list evict(size_t incoming_bytes);
+
+  /// @brief Releases unpinned pages, least recently used first, until the memory usage is no more than a limit.
+  ///        Clean pages are released right away. Dirty pages stop counting towards the memory usage, but are only
+  ///        marked as busy, since writing them back is done outside of the lock.
+  ///
+  /// @return The evicted pages that are dirty.
+  [[nodiscard]] write_back_list evict_until(size_t limit);
+
+  /// @brief Writes back evicted pages and then releases them. The caller must not hold the lock.
+  void write_back(const write_back_list& pages);
+
+  /// @brief Releases a page, which must not be pinned. The caller must hold the lock.
+  void erase_page(std::map<page_key, page>::iterator it);
+
+  size_t memory_budget_{ 0 };
+
+  size_t memory_usage_{ 0 };
+
+  std::string directory_;
+
+  std::shared_ptr<memory_allocator> allocator_;
+
+  std::map<page_key, page> pages_;
+
+  /// @brief The loaded pages, from the most recently used to the least recently used.
+  std::list<page_key> lru_;
+
+  std::mutex lock_;
+
+  /// @brief Signaled whenever a page stops being busy.
+  std::condition_variable io_done_;
+};
+
+/// @brief A texture whose texels are stored in a file, one tile after another, and streamed through a page cache.
+///        This allows textures far larger than the available memory.
+class paged_texture final : public texture
+{
+public:
+  /// @brief The size of a tile, in both axes.
+  static constexpr uint32_t tile_size() { return 64; }
+
+  /// @brief Called with a message when reading or writing the backing file fails.
+  using error_func = std::function<void(const std::string& msg)>;
+
+  /// @brief Creates a new paged texture, along with the file that backs it.
+  ///
+  /// @param size The size of the texture, in both axes.
+  ///
+  /// @param cache The cache to load tiles into.
+  ///
+  /// @param on_error If not null, the function to report failures to read or write the backing file to.
+  ///
+  /// @return A new paged texture, or a null pointer if the backing file could not be created.
+  static std::unique_ptr<paged_texture> create(uint32_t size,
+                                               std::shared_ptr<page_cache> cache,
+                                               error_func on_error = nullptr);
+
+  paged_texture(const paged_texture&) = delete;
+
+  ~paged_texture() override;
+
+  void read_data(float* data) override;
+
+  [[nodiscard]] uint32_t get_size() const override { return size_; }
+
+  [[nodiscard]] texture_desc get_desc() const override;
+
+  /// @note Only tiles currently loaded into the page cache are counted.
+  [[nodiscard]] size_t get_memory_usage() const override { return resident_bytes_.load(std::memory_order_relaxed); }
+
+  [[nodiscard]] uint32_t get_tile_size() const override { return tile_size(); }
+
+  texel_tile map_region(glm::uvec2 origin, glm::uvec2 size, tile_access access) override;
+
+  void unmap_region(const texel_tile& tile, tile_access access) override;
+
+  void* get_data_pointer() override { return nullptr; }
+
+  [[nodiscard]] const void* get_data_pointer() const override { return nullptr; }
+
+  /// @brief Gets the cache that the tiles of the texture are loaded into.
+  [[nodiscard]] const std::shared_ptr<page_cache>& get_cache() const { return cache_; }
+
+  /// @brief Indicates whether reading or writing the backing file has failed.
+  ///        From then on the contents of the texture can not be trusted, and mapping its regions fails.
+  [[nodiscard]] bool has_failed() const { return failed_.load(std::memory_order_relaxed); }
+
+  /// @brief Reads a tile from the backing file.
+  ///        Parts of the file that have never been written read as zero.
+  ///        If the read fails, the texture is marked as failed and the texels that were not read are zeroed.
+  ///
+  /// @return True if the tile was read, false otherwise.
+  bool read_tile(uint32_t tile_index, glm::vec4* texels);
+
+  /// @brief Writes a tile to the backing file.
+  ///        If the write fails, the texture is marked as failed.
+  ///
+  /// @return True if the tile was written, false otherwise.
+  bool write_tile(uint32_t tile_index, const glm::vec4* texels);
+
+private:
+  friend page_cache;
+
+  paged_texture(uint32_t size, std::shared_ptr<page_cache> cache, int file_descriptor, error_func on_error);
+
+  /// @brief Marks the texture as failed and reports why.
+  void fail(const char* msg);
+
+  const uint32_t size_{ 0 };
+
+  const uint32_t tiles_per_axis_{ 0 };
+
+  std::shared_ptr<page_cache> cache_;
+
+  int file_descriptor_{ -1 };
+
+  error_func on_error_;
+
+  /// @brief Whether reading or writing the backing file has failed.
+  std::atomic<bool> failed_{ false };
+
+  /// @brief The number of bytes of tiles that the page cache currently holds for this texture.
+  std::atomic<size_t> resident_bytes_{ 0 };
+};
+
+} // namespace ptg
@@ -0,0 +1,134 @@
+#include "perf_counters.hpp"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+
+namespace ptg {
+
+namespace {
+
+#ifdef __linux__
+/// @brief Opens a counter for the calling thread, in user space only.
+///
+/// @param type The type of the event.
+///
+/// @param config The event to count, which depends on the type.
+///
+/// @param group The file descriptor of the group leader, or -1 to open a new group.
+///
+/// @return The file descriptor of the counter, or -1 on failure.
+int
+open_counter(const uint32_t type, const uint64_t config, const int group)
+{
+  perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP;
+
+  return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+}
+
+/// @brief Makes the configuration of a cache read miss event.
+constexpr uint64_t
+cache_read_miss(const uint64_t cache)
+{
+  return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+#endif
+
+} // namespace
+
+perf_counters::perf_counters()
+{
+#ifdef __linux__
+  struct event_config final
+  {
+    uint32_t type;
+
+    uint64_t config;
+  };
+
+  const event_config configs[event_count]{
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HW_CACHE, cache_read_miss(PERF_COUNT_HW_CACHE_LL) },
+    { PERF_TYPE_HW_CACHE, cache_read_miss(PERF_COUNT_HW_CACHE_DTLB) },
+  };
+
+  leader_ = open_counter(configs[cycles_event].type, configs[cycles_event].config, -1);
+  if (leader_ < 0)
+    return;
+
+  descriptors_[cycles_event] = leader_;
+
+  positions_[cycles_event] = group_size_++;
+
+  for (int i = cycles_event + 1; i < event_count; i++) {
+
+    descriptors_[i] = open_counter(configs[i].type, configs[i].config, leader_);
+
+    if (descriptors_[i] >= 0)
+      positions_[i] = group_size_++;
+  }
+#endif
+}
+
+perf_counters::~perf_counters()
+{
+#ifdef __linux__
+  for (const auto fd : descriptors_) {
+    if (fd >= 0)
+      close(fd);
+  }
+#endif
+}
+
+perf_counters&
+perf_counters::get_thread_counters()
+{
+  thread_local perf_counters counters;
+
+  return counters;
+}
+
+bool
+perf_counters::read(perf_sample* sample) const
+{
+#ifdef __linux__
+  if (leader_ < 0)
+    return false;
+
+  // With PERF_FORMAT_GROUP, the group is read as the number of events followed by the value of each event.
+  uint64_t values[1 + event_count]{};
+
+  const auto expected_size = static_cast<ssize_t>((1 + group_size_) * sizeof(uint64_t));
+
+  if (::read(leader_, values, sizeof(values)) < expected_size)
+    return false;
+
+  auto get_value = [this, &values](const int event) -> uint64_t {
+    return (positions_[event] >= 0) ? values[1 + positions_[event]] : 0;
+  };
+
+  sample->cycles = get_value(cycles_event);
+  sample->instructions = get_value(instructions_event);
+  sample->llc_misses = get_value(llc_misses_event);
+  sample->dtlb_misses = get_value(dtlb_misses_event);
+
+  return true;
+#else
+  (void)sample;
+  return false;
+#endif
+}
+
+} // namespace ptg
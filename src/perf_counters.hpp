@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace ptg {
+
+/// @brief Counts of hardware events, as read from @ref perf_counters.
+struct perf_sample final
+{
+  uint64_t cycles{ 0 };
+
+  uint64_t instructions{ 0 };
+
+  /// @brief Reads that missed the last level cache.
+  uint64_t llc_misses{ 0 };
+
+  /// @brief Reads that missed the data TLB.
+  uint64_t dtlb_misses{ 0 };
+};
+
+/// @brief Hardware event counters for the calling thread, read through perf_event_open.
+///
+/// @details Counters are opened as a group, so that every event is counted over the same interval. Events that the
+///          machine does not support (or that the process is not allowed to count) read as zero. If the cycle counter
+///          cannot be opened, no counters are available at all, and reading them fails. This is the case on systems
+///          other than Linux.
+class perf_counters final
+{
+public:
+  perf_counters(const perf_counters&) = delete;
+
+  perf_counters(perf_counters&&) = delete;
+
+  perf_counters& operator=(const perf_counters&) = delete;
+
+  perf_counters& operator=(perf_counters&&) = delete;
+
+  ~perf_counters();
+
+  /// @brief Gets the counters of the calling thread, opening them on first use.
+  ///
+  /// @return The counters of the calling thread.
+  static perf_counters& get_thread_counters();
+
+  /// @brief Indicates whether the counters were opened.
+  [[nodiscard]] bool is_available() const { return leader_ >= 0; }
+
+  /// @brief Reads the current counts of the calling thread. Counts only increase, so an interval is measured by
+  ///        subtracting two samples.
+  ///
+  /// @param sample Assigned the current counts.
+  ///
+  /// @return True on success, false if the counters are unavailable.
+  bool read(perf_sample* sample) const;
+
+private:
+  perf_counters();
+
+  /// @brief The events that are counted, in the order that they are added to the group.
+  enum event_index
+  {
+    cycles_event,
+    instructions_event,
+    llc_misses_event,
+    dtlb_misses_event,
+    event_count
+  };
+
+  /// @brief The file descriptor of the group leader, which counts cycles.
+  int leader_{ -1 };
+
+  /// @brief The file descriptor of each event, or -1 for events that could not be opened.
+  int descriptors_[event_count]{ -1, -1, -1, -1 };
+
+  /// @brief The position of each event in the values read from the group, or -1 for events that are not counted.
+  int positions_[event_count]{ -1, -1, -1, -1 };
+
+  /// @brief The number of events in the group.
+  int group_size_{ 0 };
+};
+
+} // namespace ptg
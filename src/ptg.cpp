@@ -1,9 +1,15 @@
 #include <ptg.h>
 
+#include "chunk_manager.hpp"
+#include "command_list.hpp"
 #include "cpu_device.hpp"
+#include "device_stats.hpp"
+#include "perf_counters.hpp"
 #include "model.hpp"
 #include "output.hpp"
+#include "paged_texture.hpp"
 #include "render.hpp"
+#include "trace.hpp"
 
 //============//
 // Device API //
@@ -16,11 +22,49 @@ struct ptg_device
 
 PtgDevice*
 PtgDevice_New(const ptg_gl_symbol_loader gl_symbol_loader, void* logger_data, ptg_log_callback logger_func)
+{
+  PtgDeviceOptions options;
+  PtgDeviceOptions_Init(&options);
+  options.gl_symbol_loader = gl_symbol_loader;
+  options.logger_data = logger_data;
+  options.logger_func = logger_func;
+  return PtgDevice_NewWithOptions(&options);
+}
+
+void
+PtgDeviceOptions_Init(PtgDeviceOptions* options)
+{
+  options->gl_symbol_loader = nullptr;
+  options->logger_data = nullptr;
+  options->logger_func = nullptr;
+  options->scheduler.scheduler_data = nullptr;
+  options->scheduler.submit = nullptr;
+  options->scheduler.wait = nullptr;
+  options->memory_budget = 0;
+  options->allocator.allocator_data = nullptr;
+  options->allocator.alloc = nullptr;
+  options->allocator.realloc = nullptr;
+  options->allocator.free = nullptr;
+  options->log_mode = PTG_LOG_IMMEDIATE;
+  options->log_queue_capacity = 0;
+  options->log_level = PTG_INFO;
+}
+
+PtgDevice*
+PtgDevice_NewWithOptions(const PtgDeviceOptions* options)
 {
   auto* device = new ptg_device;
 
-  if (!gl_symbol_loader)
-    device->impl = ptg::create_cpu_device(logger_data, logger_func);
+  const auto* scheduler = (options->scheduler.submit && options->scheduler.wait) ? &options->scheduler : nullptr;
+
+  const auto* allocator = (options->allocator.alloc && options->allocator.free) ? &options->allocator : nullptr;
+
+  if (!options->gl_symbol_loader) {
+    device->impl = ptg::create_cpu_device(options->logger_data, options->logger_func, scheduler, allocator);
+    device->impl->set_memory_budget(options->memory_budget);
+    device->impl->set_log_level(options->log_level);
+    device->impl->set_log_mode(options->log_mode, options->log_queue_capacity);
+  }
 
   return device;
 }
@@ -31,6 +75,71 @@ PtgDevice_Delete(PtgDevice* device)
   delete device;
 }
 
+void
+PtgDevice_EnableStats(PtgDevice* device, const bool enabled)
+{
+  device->impl->get_stats()->enabled = enabled;
+}
+
+void
+PtgDevice_GetStats(PtgDevice* device, PtgDeviceStats* stats)
+{
+  device->impl->get_stats()->read(stats);
+}
+
+void
+PtgDevice_ResetStats(PtgDevice* device)
+{
+  device->impl->get_stats()->reset();
+}
+
+bool
+PtgDevice_EnablePerfCounters(PtgDevice* device, const bool enabled)
+{
+  // Counters are opened per thread, so this checks whether the calling thread can open them.
+  const bool available = ptg::perf_counters::get_thread_counters().is_available();
+
+  device->impl->get_stats()->perf_enabled = enabled && available;
+
+  return available;
+}
+
+void
+PtgDevice_GetMemoryStats(PtgDevice* device, PtgMemoryStats* stats)
+{
+  device->impl->get_memory_stats()->read(stats);
+}
+
+void
+PtgDevice_SetMemoryBudget(PtgDevice* device, const uint64_t budget)
+{
+  device->impl->set_memory_budget(budget);
+}
+
+void
+PtgDevice_EnableTrace(PtgDevice* device, const uint32_t event_capacity)
+{
+  device->impl->get_trace()->enable(event_capacity);
+}
+
+bool
+PtgDevice_WriteTrace(PtgDevice* device, const char* path)
+{
+  return device->impl->get_trace()->write(path);
+}
+
+void
+PtgDevice_FlushLog(PtgDevice* device)
+{
+  device->impl->flush_log();
+}
+
+void
+PtgDevice_SetLogLevel(PtgDevice* device, const PtgSeverity level)
+{
+  device->impl->set_log_level(level);
+}
+
 //===========//
 // Model API //
 //===========//
@@ -58,6 +167,12 @@ PtgModel_SetBrushSize(PtgModel* model, float brush_size)
   model->impl.set_brush_size(brush_size);
 }
 
+void
+PtgModel_SetBrushRadius(PtgModel* model, float brush_radius)
+{
+  model->impl.set_brush_radius(brush_radius);
+}
+
 void
 PtgModel_BeginPath(PtgModel* model)
 {
@@ -84,18 +199,81 @@ struct ptg_output
 {
   ptg::output impl;
 
-  ptg_output(PtgDevice* device, const uint32_t terrain_size)
-    : impl(device->impl, terrain_size)
+  ptg_output(PtgDevice* device, const uint32_t terrain_size, ptg::texture_desc layer_desc = ptg::texture_desc{})
+    : impl(device->impl, terrain_size, std::move(layer_desc))
   {
   }
 };
 
+void
+PtgOutputOptions_Init(PtgOutputOptions* options)
+{
+  options->storage = PTG_STORAGE_MEMORY;
+  options->layout = PTG_TEXEL_LAYOUT_LINEAR;
+  options->format = PTG_TEXEL_FORMAT_FLOAT32;
+  options->format_scale = 1024.0f;
+  options->format_offset = 0.0f;
+  options->memory_budget = 256ull * 1024ull * 1024ull;
+  options->page_directory = nullptr;
+  options->mapped_path = nullptr;
+  options->map_flags = 0;
+  options->max_error = 0.0f;
+}
+
 PtgOutput*
 PtgOutput_New(PtgDevice* device, const uint32_t terrain_size)
 {
   return new ptg_output(device, terrain_size);
 }
 
+PtgOutput*
+PtgOutput_NewWithOptions(PtgDevice* device, const uint32_t terrain_size, const PtgOutputOptions* options)
+{
+  ptg::texture_desc layer_desc;
+
+  switch (options->storage) {
+    case PTG_STORAGE_MEMORY:
+      layer_desc.storage = ptg::texture_storage::memory;
+      layer_desc.layout =
+        (options->layout == PTG_TEXEL_LAYOUT_TILED) ? ptg::texture_layout::tiled : ptg::texture_layout::linear;
+      switch (options->format) {
+        case PTG_TEXEL_FORMAT_FLOAT32:
+          layer_desc.format = ptg::texel_format::rgba32f;
+          break;
+        case PTG_TEXEL_FORMAT_FLOAT16:
+          layer_desc.format = ptg::texel_format::rgba16f;
+          break;
+        case PTG_TEXEL_FORMAT_UNORM16:
+          layer_desc.format = ptg::texel_format::rgba16_unorm;
+          break;
+      }
+      layer_desc.format_scale = options->format_scale;
+      layer_desc.format_offset = options->format_offset;
+      break;
+    case PTG_STORAGE_SPARSE:
+      layer_desc.storage = ptg::texture_storage::sparse;
+      break;
+    case PTG_STORAGE_MAPPED:
+      layer_desc.storage = ptg::texture_storage::mapped;
+      layer_desc.path = options->mapped_path ? options->mapped_path : "";
+      layer_desc.map_flags = options->map_flags;
+      break;
+    case PTG_STORAGE_COMPRESSED:
+      layer_desc.storage = ptg::texture_storage::compressed;
+      layer_desc.max_error = options->max_error;
+      break;
+    case PTG_STORAGE_PAGED:
+      layer_desc.storage = ptg::texture_storage::paged;
+      // All layers of the output share one cache, so the budget covers the output as a whole.
+      layer_desc.cache = std::make_shared<ptg::page_cache>(static_cast<size_t>(options->memory_budget),
+                                                           options->page_directory ? options->page_directory : "",
+                                                           device->impl->get_allocator());
+      break;
+  }
+
+  return new ptg_output(device, terrain_size, std::move(layer_desc));
+}
+
 void
 PtgOutput_Delete(PtgOutput* output)
 {
@@ -120,6 +298,61 @@ PtgOutput_SaveHeightPng(PtgOutput* output, const char* filename, ptg_write_png p
   return output->impl.save_height_png(filename, png_writer);
 }
 
+void
+PtgOutput_GetMemoryStats(PtgOutput* output, PtgMemoryStats* stats)
+{
+  output->impl.get_memory_stats()->read(stats);
+}
+
+//===========//
+// Chunk API //
+//===========//
+
+struct ptg_chunk_cache
+{
+  ptg::chunk_manager impl;
+
+  ptg_chunk_cache(PtgDevice* device, const uint32_t chunk_size, const uint64_t memory_budget)
+    : impl(device->impl, chunk_size, static_cast<size_t>(memory_budget))
+  {
+  }
+};
+
+PtgChunkCache*
+PtgChunkCache_New(PtgDevice* device, const uint32_t chunk_size, const uint64_t memory_budget)
+{
+  if (!ptg::chunk_manager::is_valid_chunk_size(chunk_size)) {
+    device->impl->error("Failed to create chunk cache because the chunk size is not a non-zero multiple of 8.");
+    return nullptr;
+  }
+
+  return new ptg_chunk_cache(device, chunk_size, memory_budget);
+}
+
+void
+PtgChunkCache_Delete(PtgChunkCache* cache)
+{
+  delete cache;
+}
+
+void
+PtgChunkCache_SetModel(PtgChunkCache* cache, PtgModel* model)
+{
+  cache->impl.set_model(model->impl);
+}
+
+void
+PtgChunkCache_ReadHeight(PtgChunkCache* cache, const int32_t x, const int32_t y, float* heights)
+{
+  cache->impl.get_chunk(ptg::chunk_key{ x, y })->read_height(heights);
+}
+
+uint32_t
+PtgChunkCache_Prefetch(PtgChunkCache* cache, const float* trajectory, const uint32_t point_count, const uint32_t radius)
+{
+  return cache->impl.prefetch(reinterpret_cast<const glm::vec2*>(trajectory), point_count, radius);
+}
+
 //============//
 // Render API //
 //============//
@@ -178,3 +411,72 @@ PtgRender_SavePng(PtgRender* render, const char* path, ptg_write_png png_writer)
 {
   render->impl.save_to_png(path, png_writer);
 }
+
+void
+PtgRender_GetMemoryStats(PtgRender* render, PtgMemoryStats* stats)
+{
+  render->impl.get_memory_stats()->read(stats);
+}
+
+//==================//
+// Command list API //
+//==================//
+
+struct ptg_command_list
+{
+  ptg::command_list impl;
+};
+
+PtgCommandList*
+PtgCommandList_New(PtgDevice* device)
+{
+  return new ptg_command_list{ ptg::command_list(device->impl) };
+}
+
+void
+PtgCommandList_Delete(PtgCommandList* list)
+{
+  delete list;
+}
+
+void
+PtgCommandList_Reset(PtgCommandList* list)
+{
+  list->impl.reset();
+}
+
+void
+PtgCommandList_PrepareBake(PtgCommandList* list, PtgOutput* output, PtgModel* model)
+{
+  list->impl.prepare_bake(output->impl, model->impl);
+}
+
+void
+PtgCommandList_IterateBake(PtgCommandList* list, PtgOutput* output, const uint32_t step_count)
+{
+  list->impl.iterate_bake(output->impl, step_count);
+}
+
+void
+PtgCommandList_SaveHeightPng(PtgCommandList* list, PtgOutput* output, const char* path, ptg_write_png png_writer)
+{
+  list->impl.save_height_png(output->impl, path, png_writer);
+}
+
+void
+PtgCommandList_IterateRender(PtgCommandList* list, PtgRender* render, const uint32_t sample_count)
+{
+  list->impl.iterate_render(render->impl, sample_count);
+}
+
+void
+PtgCommandList_SaveRenderPng(PtgCommandList* list, PtgRender* render, const char* path, ptg_write_png png_writer)
+{
+  list->impl.save_render_png(render->impl, path, png_writer);
+}
+
+bool
+PtgCommandList_Submit(PtgCommandList* list)
+{
+  return list->impl.submit();
+}
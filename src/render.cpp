@@ -2,69 +2,130 @@
 
 #include "kernel_registry.hpp"
 #include "kernel.hpp"
+#include "kernel_params.hpp"
 #include "texture.hpp"
+#include "trace.hpp"
 
 #include <vector>
 
 namespace ptg {
 
+namespace {
+
+texture_desc
+make_color_desc(const uint32_t image_size)
+{
+  // The color is only accessed by kernels and read back through read_data, so the layout is free to favor the
+  // kernels.
+  texture_desc desc;
+  desc.size = image_size;
+  desc.layout = texture_layout::tiled;
+  return desc;
+}
+
+} // namespace
+
 render::render(std::shared_ptr<device> dev, const uint32_t image_size)
   : device_(std::move(dev))
-    , color_(device_->create_texture(image_size))
+    , color_(device_->create_texture(make_color_desc(image_size)))
+    , kernel_(device_->get_kernel_registry()->render_kernel())
+{
+  if (color_) {
+    memory_.record_allocation();
+    memory_.update(color_->get_memory_usage());
+  }
+}
+
+render::~render()
 {
+  if (color_)
+    device_->destroy_texture(color_);
+}
+
+const memory_stats*
+render::get_memory_stats()
+{
+  memory_.update(color_ ? color_->get_memory_usage() : 0);
+
+  return &memory_;
 }
 
 void
 render::iterate()
 {
-  auto* next_texture = device_->create_texture(color_->get_size());
-
-  auto* kern = device_->get_kernel_registry()->render_kernel;
+  const trace_scope scope(device_->get_trace(), "render iteration", "render");
 
-  const auto image_size = color_->get_size();
+  if (!color_) {
+    device_->error("Failed to render because the color texture could not be created.");
+    return;
+  }
 
-  const auto previous_texture_location = kern->get_uniform_location("previous_texture");
+  auto* kern = kernel_.get();
 
-  const auto next_texture_location = kern->get_uniform_location("next_texture");
+  // Samples are accumulated into the color texture directly when the kernel allows it, which saves a texture.
+  const bool in_place = kern->supports_in_place();
 
-  const auto camera_position_location = kern->get_uniform_location("camera_position");
+  auto* next_texture = in_place ? color_ : device_->create_texture(color_->get_desc());
 
-  const auto camera_rotation_location = kern->get_uniform_location("camera_rotation");
+  if (!next_texture) {
+    device_->error("Failed to render because the next color texture could not be created.");
+    return;
+  }
 
-  const auto unit_sphere_location = kern->get_uniform_location("unit_sphere_sample");
+  if (!in_place)
+    memory_.record_allocation();
 
-  const auto pixel_coordinate_location = kern->get_uniform_location("pixel_coordinate");
+  const auto image_size = color_->get_size();
 
   const auto work_group_count = glm::uvec2(image_size, image_size) / device_->get_work_group_size();
 
   kern->set_active_texture(0, color_);
 
-  kern->set_active_texture(1, next_texture);
+  kern->set_active_texture(1, in_place ? nullptr : next_texture);
 
-  kern->set_uniform_int(previous_texture_location, 0);
+  render_params params;
 
-  kern->set_uniform_int(next_texture_location, 1);
+  params.previous_texture = 0;
 
-  kern->set_uniform_vec3(camera_position_location, camera_.position);
+  params.next_texture = in_place ? 0 : 1;
 
-  kern->set_uniform_vec3(camera_rotation_location, camera_.rotation);
+  params.camera_position = camera_.position;
 
-  kern->set_uniform_vec3(unit_sphere_location, sample_unit_sphere());
+  params.camera_rotation = camera_.rotation;
 
-  kern->set_uniform_vec2(pixel_coordinate_location, sample_unit_square());
+  params.unit_sphere_sample = sample_unit_sphere();
 
-  kern->dispatch(work_group_count);
+  params.pixel_coordinate = sample_unit_square();
 
-  device_->destroy_texture(color_);
+  if (!kern->set_params(params)) {
+    device_->error("Failed to render because the kernel does not accept render parameters.");
+    if (!in_place)
+      device_->destroy_texture(next_texture);
+    return;
+  }
 
-  color_ = next_texture;
+  kern->dispatch(work_group_count);
 
   samples_per_pixel_++;
+
+  if (!in_place) {
+    device_->destroy_texture(color_);
+    color_ = next_texture;
+  }
+
+  memory_.update(color_->get_memory_usage());
 }
 
 bool
 render::save_to_png(const char* path, ptg_write_png png_writer) const
 {
+  const trace_scope scope(device_->get_trace(), "save render png", "export");
+
+  if (!color_) {
+    device_->error("Failed to save render PNG because the color texture could not be created.");
+    return false;
+  }
+
   const auto image_size = color_->get_size();
 
   std::vector<float> color(image_size * image_size * 4);
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "device.hpp"
+#include "device_stats.hpp"
+#include "kernel.hpp"
 
 #include <memory>
 #include <random>
@@ -29,6 +31,16 @@ class render final
 public:
   render(std::shared_ptr<device> dev, uint32_t image_size);
 
+  render(const render&) = delete;
+
+  render(render&&) = delete;
+
+  render& operator=(const render&) = delete;
+
+  render& operator=(render&&) = delete;
+
+  ~render();
+
   camera* get_camera() { return &camera_; }
 
   [[nodiscard]] const camera* get_camera() const { return &camera_; }
@@ -45,6 +57,12 @@ public:
   /// @return True on success, false on failure.
   bool save_to_png(const char* path, ptg_write_png png_writer) const;
 
+  /// @brief Gets the memory held by the color texture of the render.
+  ///        The live bytes (and the peak, if exceeded) are brought up to date before returning.
+  ///
+  /// @return The memory counters of the render.
+  const memory_stats* get_memory_stats();
+
 private:
   /// @brief Samples the unit square.
   ///
@@ -59,9 +77,16 @@ private:
   /// @brief The device that owns the render job.
   std::shared_ptr<device> device_;
 
-  /// @brief The texture containing the render result.
+  /// @brief The memory held by the color texture. This is declared before it, since creating it counts an
+  ///        allocation.
+  memory_stats memory_;
+
+  /// @brief The texture containing the render result, which is null if it could not be created.
   texture* color_{ nullptr };
 
+  /// @brief The render kernel instance of this render job, which holds its parameters and bindings.
+  std::unique_ptr<kernel> kernel_;
+
   /// @brief Describes where the terrain will be rendered from.
   camera camera_;
 
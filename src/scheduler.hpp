@@ -0,0 +1,37 @@
+#pragma once
+
+#include <functional>
+
+#include <stdint.h>
+
+namespace ptg {
+
+/// @brief The interface for running loops in parallel.
+///        Devices spread kernel dispatches and other device work through a scheduler, so that the work can run on
+///        threads owned by the device or on the workers of a job system in the calling environment.
+class scheduler
+{
+public:
+  scheduler() = default;
+
+  scheduler(const scheduler&) = delete;
+
+  scheduler(scheduler&&) = delete;
+
+  scheduler& operator=(const scheduler&) = delete;
+
+  scheduler& operator=(scheduler&&) = delete;
+
+  virtual ~scheduler() = default;
+
+  /// @brief Calls a function once for each index in [0, count), spreading the calls across threads.
+  ///        This function returns once every index has been processed. It may be called from several threads at
+  ///        once, and from within the function of another loop.
+  ///
+  /// @param count The number of indices to process.
+  ///
+  /// @param func The function to call for each index.
+  virtual void parallel_for(uint32_t count, const std::function<void(uint32_t index)>& func) = 0;
+};
+
+} // namespace ptg
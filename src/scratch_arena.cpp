@@ -0,0 +1,57 @@
+#include "scratch_arena.hpp"
+
+#include <cstdint>
+
+namespace ptg {
+
+scratch_arena&
+scratch_arena::get_thread_arena()
+{
+  thread_local scratch_arena arena;
+
+  return arena;
+}
+
+void*
+scratch_arena::allocate(const size_t size, const size_t alignment)
+{
+  // Blocks are allocated with extra room, so that their start can be aligned to the largest supported alignment.
+  constexpr size_t max_alignment = 64;
+
+  auto align = [alignment](const block& b, const size_t offset) {
+    const auto address = reinterpret_cast<uintptr_t>(b.data.get()) + offset;
+    const auto aligned = (address + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+    return static_cast<size_t>(aligned - reinterpret_cast<uintptr_t>(b.data.get()));
+  };
+
+  while (block_index_ < blocks_.size()) {
+
+    auto& b = blocks_[block_index_];
+
+    const auto offset = align(b, offset_);
+
+    if ((offset + size) <= b.size) {
+      offset_ = offset + size;
+      return b.data.get() + offset;
+    }
+
+    // Later blocks were allocated for earlier, larger requests, so they may still have room.
+    block_index_++;
+    offset_ = 0;
+  }
+
+  const auto block_size = (size > default_block_size) ? size : default_block_size;
+
+  blocks_.emplace_back(block{ std::unique_ptr<unsigned char[]>(new unsigned char[block_size + max_alignment]),
+                              block_size + max_alignment });
+
+  block_index_ = blocks_.size() - 1;
+
+  const auto offset = align(blocks_.back(), 0);
+
+  offset_ = offset + size;
+
+  return blocks_.back().data.get() + offset;
+}
+
+} // namespace ptg
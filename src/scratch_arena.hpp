@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <stddef.h>
+
+namespace ptg {
+
+/// @brief A bump allocator for short-lived memory.
+///
+/// @details Memory is taken from large blocks, which are kept once allocated. Allocations are released all at once,
+///          by restoring a position saved with a @ref scratch_arena::scope. Once the arena has grown to the largest
+///          amount of memory needed at once, allocating from it never calls into the heap.
+class scratch_arena final
+{
+public:
+  /// @brief Saves the position of an arena, and restores it when destroyed.
+  ///        Memory allocated within the lifetime of the scope is released when the scope ends.
+  class scope final
+  {
+  public:
+    explicit scope(scratch_arena& arena)
+      : arena_(arena)
+        , block_index_(arena.block_index_)
+        , offset_(arena.offset_)
+    {
+    }
+
+    scope(const scope&) = delete;
+
+    scope& operator=(const scope&) = delete;
+
+    ~scope()
+    {
+      arena_.block_index_ = block_index_;
+      arena_.offset_ = offset_;
+    }
+
+  private:
+    scratch_arena& arena_;
+
+    size_t block_index_{ 0 };
+
+    size_t offset_{ 0 };
+  };
+
+  /// @brief Gets the arena of the calling thread.
+  ///        Kernels take temporary arrays from it while processing a tile, and textures that convert their texels
+  ///        when mapped (such as compressed and packed textures) place the mapped texels in it.
+  ///
+  /// @return The arena of the calling thread.
+  static scratch_arena& get_thread_arena();
+
+  /// @brief Allocates memory from the arena.
+  ///
+  /// @param size The number of bytes to allocate.
+  ///
+  /// @param alignment The alignment of the memory. This must be a power of two no larger than 64.
+  ///
+  /// @return A pointer to the memory, which remains valid until the enclosing scope ends.
+  void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+  /// @brief Allocates an array from the arena. The elements are not initialized.
+  ///
+  /// @param count The number of elements to allocate.
+  ///
+  /// @return A pointer to the first element.
+  template<typename T>
+  T* allocate_array(const size_t count)
+  {
+    return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+  }
+
+private:
+  /// @brief A block of memory that allocations are taken from.
+  struct block final
+  {
+    std::unique_ptr<unsigned char[]> data;
+
+    size_t size{ 0 };
+  };
+
+  /// @brief The size of a block, unless an allocation needs a larger one.
+  static constexpr size_t default_block_size = 64 * 1024;
+
+  std::vector<block> blocks_;
+
+  /// @brief The block that allocations are currently taken from.
+  size_t block_index_{ 0 };
+
+  /// @brief The offset of the next allocation within the current block.
+  size_t offset_{ 0 };
+};
+
+} // namespace ptg
@@ -0,0 +1,178 @@
+#include "sparse_texture.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ptg {
+
+namespace {
+
+constexpr uint32_t tile_texel_count = sparse_texture::tile_size() * sparse_texture::tile_size();
+
+constexpr size_t tile_bytes = tile_texel_count * sizeof(glm::vec4);
+
+} // namespace
+
+void
+sparse_texture::tile_deleter::operator()(glm::vec4* tile) const
+{
+  allocator->deallocate(tile, tile_bytes);
+}
+
+sparse_texture::sparse_texture(const uint32_t size, std::shared_ptr<memory_allocator> allocator)
+  : size_(size)
+    , tiles_per_axis_((size + tile_size() - 1) / tile_size())
+    , allocator_(std::move(allocator))
+    , tiles_(tiles_per_axis_ * tiles_per_axis_)
+    , constants_(tiles_per_axis_ * tiles_per_axis_, glm::vec4(0.0f))
+    , zero_tile_(allocate_tile())
+{
+  if (!zero_tile_)
+    throw std::bad_alloc();
+
+  std::fill_n(zero_tile_.get(), tile_texel_count, glm::vec4(0.0f));
+}
+
+void
+sparse_texture::read_data(float* data)
+{
+  for (uint32_t y = 0; y < size_; y++) {
+
+    for (uint32_t x = 0; x < size_; x++) {
+
+      const auto tile_index = get_tile_index({ x, y });
+
+      const auto* tile = tiles_[tile_index].get();
+
+      const auto t = tile ? tile[((y % tile_size()) * tile_size()) + (x % tile_size())] : constants_[tile_index];
+
+      const auto offset = ((y * size_) + x) * 4;
+
+      data[offset + 0] = t.r;
+      data[offset + 1] = t.g;
+      data[offset + 2] = t.b;
+      data[offset + 3] = t.a;
+    }
+  }
+}
+
+texture_desc
+sparse_texture::get_desc() const
+{
+  texture_desc desc;
+  desc.size = size_;
+  desc.storage = texture_storage::sparse;
+  return desc;
+}
+
+size_t
+sparse_texture::get_memory_usage() const
+{
+  const size_t constant_bytes = constants_.size() * sizeof(glm::vec4);
+
+  return (allocated_tiles_.load(std::memory_order_relaxed) * tile_bytes) + tile_bytes + constant_bytes;
+}
+
+texel_tile
+sparse_texture::map_region(const glm::uvec2 origin, const glm::uvec2 size, const tile_access access)
+{
+  const auto tile_index = get_tile_index(origin);
+
+  const auto offset = origin % tile_size();
+
+  auto* tile = tiles_[tile_index].get();
+
+  if (!tile) {
+    if ((access == tile_access::read_only) && (constants_[tile_index] == glm::vec4(0.0f)))
+      tile = zero_tile_.get();
+    else
+      tile = allocate(tile_index);
+  }
+
+  if (!tile)
+    return texel_tile{};
+
+  return texel_tile{ tile + (offset.y * tile_size()) + offset.x, origin, size, tile_size() };
+}
+
+bool
+sparse_texture::is_constant(const glm::uvec2 origin, const glm::uvec2, glm::vec4* value)
+{
+  const auto tile_index = get_tile_index(origin);
+
+  if (tiles_[tile_index])
+    return false;
+
+  *value = constants_[tile_index];
+
+  return true;
+}
+
+void
+sparse_texture::fill_region(const glm::uvec2 origin, const glm::uvec2 size, const glm::vec4& value)
+{
+  const auto tile_index = get_tile_index(origin);
+
+  const auto tile_origin = origin - (origin % tile_size());
+
+  const auto full_tile = glm::min(glm::uvec2(tile_size()), glm::uvec2(size_) - tile_origin);
+
+  if ((origin == tile_origin) && (size == full_tile)) {
+    // The whole tile becomes constant, so its storage is no longer needed.
+    std::lock_guard<std::mutex> guard(lock_);
+    if (tiles_[tile_index])
+      allocated_tiles_.fetch_sub(1, std::memory_order_relaxed);
+    tiles_[tile_index].reset();
+    constants_[tile_index] = value;
+    return;
+  }
+
+  const auto tile = map_region(origin, size, tile_access::write_only);
+  if (!tile.data)
+    return;
+
+  for (uint32_t y = 0; y < size.y; y++)
+    std::fill_n(&tile.data[y * tile.pitch], size.x, value);
+}
+
+uint32_t
+sparse_texture::get_allocated_tile_count() const
+{
+  return static_cast<uint32_t>(std::count_if(tiles_.begin(), tiles_.end(), [](const auto& t) { return !!t; }));
+}
+
+sparse_texture::tile_ptr
+sparse_texture::allocate_tile()
+{
+  auto* tile = static_cast<glm::vec4*>(allocator_->allocate(tile_bytes, texel_alignment));
+
+  return tile_ptr(tile, tile_deleter{ allocator_.get() });
+}
+
+uint32_t
+sparse_texture::get_tile_index(const glm::uvec2 texel) const
+{
+  const auto tile_pos = texel / tile_size();
+
+  return (tile_pos.y * tiles_per_axis_) + tile_pos.x;
+}
+
+glm::vec4*
+sparse_texture::allocate(const uint32_t tile_index)
+{
+  std::lock_guard<std::mutex> guard(lock_);
+
+  auto& tile = tiles_[tile_index];
+
+  if (!tile) {
+    tile = allocate_tile();
+    if (!tile)
+      return nullptr;
+    std::fill_n(tile.get(), tile_texel_count, constants_[tile_index]);
+    allocated_tiles_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  return tile.get();
+}
+
+} // namespace ptg
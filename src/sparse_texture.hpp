@@ -0,0 +1,100 @@
+#pragma once
+
+#include "texel_allocator.hpp"
+#include "texture.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ptg {
+
+/// @brief A texture that only allocates the tiles that are written to.
+///        Tiles that have not been written to read as a constant value and cost no memory.
+class sparse_texture final : public texture
+{
+public:
+  /// @brief The size of a tile, in both axes.
+  static constexpr uint32_t tile_size() { return 64; }
+
+  /// @brief Constructs a new sparse texture, where every tile reads as zero.
+  ///
+  /// @param size The size of the texture, in both axes.
+  ///
+  /// @param allocator The allocator to allocate tiles with.
+  explicit sparse_texture(uint32_t size, std::shared_ptr<memory_allocator> allocator = get_default_allocator());
+
+  void read_data(float* data) override;
+
+  [[nodiscard]] uint32_t get_size() const override { return size_; }
+
+  [[nodiscard]] texture_desc get_desc() const override;
+
+  [[nodiscard]] size_t get_memory_usage() const override;
+
+  [[nodiscard]] uint32_t get_tile_size() const override { return tile_size(); }
+
+  texel_tile map_region(glm::uvec2 origin, glm::uvec2 size, tile_access access) override;
+
+  void unmap_region(const texel_tile&, tile_access) override {}
+
+  bool is_constant(glm::uvec2 origin, glm::uvec2 size, glm::vec4* value) override;
+
+  void fill_region(glm::uvec2 origin, glm::uvec2 size, const glm::vec4& value) override;
+
+  void* get_data_pointer() override { return nullptr; }
+
+  [[nodiscard]] const void* get_data_pointer() const override { return nullptr; }
+
+  /// @brief Gets the number of tiles that have storage allocated for them.
+  [[nodiscard]] uint32_t get_allocated_tile_count() const;
+
+private:
+  /// @brief Frees the storage of a tile through the allocator it came from.
+  struct tile_deleter final
+  {
+    memory_allocator* allocator;
+
+    void operator()(glm::vec4* tile) const;
+  };
+
+  using tile_ptr = std::unique_ptr<glm::vec4[], tile_deleter>;
+
+  /// @brief Allocates the storage of a tile, without initializing it.
+  ///
+  /// @return The storage of the tile, or a null pointer if it could not be allocated.
+  tile_ptr allocate_tile();
+
+  /// @brief Gets the index of the tile containing a texel.
+  [[nodiscard]] uint32_t get_tile_index(glm::uvec2 texel) const;
+
+  /// @brief Allocates storage for a tile, filled with the tile's constant value.
+  ///
+  /// @return The texels of the tile, or a null pointer if they could not be allocated.
+  glm::vec4* allocate(uint32_t tile_index);
+
+  const uint32_t size_{ 0 };
+
+  const uint32_t tiles_per_axis_{ 0 };
+
+  std::shared_ptr<memory_allocator> allocator_;
+
+  /// @brief The storage of each tile, which is null until the tile is written to.
+  std::vector<tile_ptr> tiles_;
+
+  /// @brief The value that each unallocated tile reads as.
+  std::vector<glm::vec4> constants_;
+
+  /// @brief A tile filled with zeros, returned when reading unallocated tiles that read as zero.
+  tile_ptr zero_tile_;
+
+  /// @brief The number of tiles that have storage allocated for them, kept so that memory usage can be read while
+  ///        tiles are being allocated.
+  std::atomic<uint32_t> allocated_tiles_{ 0 };
+
+  /// @brief Guards tile allocation.
+  std::mutex lock_;
+};
+
+} // namespace ptg
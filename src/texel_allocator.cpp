@@ -0,0 +1,121 @@
+#include "texel_allocator.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/mman.h>
+
+namespace ptg {
+
+namespace {
+
+size_t
+get_mapping_size(const size_t size)
+{
+  return ((size + huge_page_size - 1) / huge_page_size) * huge_page_size;
+}
+
+void*
+map_huge_pages(const size_t size)
+{
+  const auto mapping_size = get_mapping_size(size);
+
+#ifdef MAP_HUGETLB
+  // Explicit huge pages are only available if the administrator has reserved some, so this usually fails.
+  auto* mapping = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (mapping != MAP_FAILED)
+    return mapping;
+#endif
+
+  auto* data = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (data == MAP_FAILED)
+    return nullptr;
+
+#ifdef MADV_HUGEPAGE
+  // Failure only means that the pages stay small, so the result is ignored.
+  madvise(data, mapping_size, MADV_HUGEPAGE);
+#endif
+
+  return data;
+}
+
+/// @brief Whether an allocation of a given size is mapped, rather than taken from the heap.
+///        This is decided by size alone, so that the same decision can be made again when the memory is freed.
+bool
+is_mapped_size(const size_t size)
+{
+  return size >= huge_page_size;
+}
+
+/// @brief Allocates with @ref allocate_texel_storage, whose alignment covers every alignment that is asked for.
+class default_allocator final : public memory_allocator
+{
+public:
+  void* allocate(const size_t size, size_t) override { return allocate_texel_storage(size); }
+
+  void* reallocate(void* data, const size_t old_size, const size_t new_size, size_t) override
+  {
+    if (new_size == 0) {
+      free_texel_storage(data, old_size);
+      return nullptr;
+    }
+
+    // Heap allocations of the same rounded size already have room for the new size.
+    if (data && !is_mapped_size(old_size) && !is_mapped_size(new_size) &&
+        (((old_size + texel_alignment - 1) / texel_alignment) == ((new_size + texel_alignment - 1) / texel_alignment)))
+      return data;
+
+    auto* new_data = allocate_texel_storage(new_size);
+    if (!new_data)
+      return nullptr;
+
+    if (data)
+      std::memcpy(new_data, data, std::min(old_size, new_size));
+
+    free_texel_storage(data, old_size);
+
+    return new_data;
+  }
+
+  void deallocate(void* data, const size_t size) override { free_texel_storage(data, size); }
+};
+
+} // namespace
+
+const std::shared_ptr<memory_allocator>&
+get_default_allocator()
+{
+  static const std::shared_ptr<memory_allocator> allocator = std::make_shared<default_allocator>();
+
+  return allocator;
+}
+
+void*
+allocate_texel_storage(const size_t size)
+{
+  if (size == 0)
+    return nullptr;
+
+  if (is_mapped_size(size))
+    return map_huge_pages(size);
+
+  // The size passed to aligned_alloc must be a multiple of the alignment.
+  const auto aligned_size = ((size + texel_alignment - 1) / texel_alignment) * texel_alignment;
+
+  return std::aligned_alloc(texel_alignment, aligned_size);
+}
+
+void
+free_texel_storage(void* data, const size_t size)
+{
+  if (!data)
+    return;
+
+  if (is_mapped_size(size))
+    munmap(data, get_mapping_size(size));
+  else
+    std::free(data);
+}
+
+} // namespace ptg
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <stddef.h>
+
+namespace ptg {
+
+/// @brief The alignment of every allocation made for texel storage.
+///        This is the size of a cache line, so that rows and blocks of texels never share one and SIMD loads of
+///        texels are always aligned.
+constexpr size_t texel_alignment = 64;
+
+/// @brief Allocations of at least this many bytes are backed by huge pages, where possible.
+constexpr size_t huge_page_size = 2 * 1024 * 1024;
+
+/// @brief Allocates memory for texel storage.
+///
+/// @details The memory is aligned to @ref texel_alignment. Allocations of at least @ref huge_page_size bytes are
+///          mapped directly, from the explicit huge page pool if it has room and otherwise as ordinary pages
+///          marked for transparent huge pages. Smaller allocations come from the aligned heap.
+///
+/// @param size The number of bytes to allocate.
+///
+/// @return A pointer to the memory, or a null pointer if it could not be allocated.
+void*
+allocate_texel_storage(size_t size);
+
+/// @brief Frees memory allocated by @ref allocate_texel_storage.
+///
+/// @param data The pointer returned by @ref allocate_texel_storage.
+///
+/// @param size The number of bytes that were allocated.
+void
+free_texel_storage(void* data, size_t size);
+
+/// @brief The interface for allocating the memory that a device holds: texel storage, buffers and model data.
+///        Devices allocate through the allocator of the host when one is given, and otherwise through
+///        @ref get_default_allocator. Implementations must allow calls from several threads at once.
+class memory_allocator
+{
+public:
+  memory_allocator() = default;
+
+  memory_allocator(const memory_allocator&) = delete;
+
+  memory_allocator(memory_allocator&&) = delete;
+
+  memory_allocator& operator=(const memory_allocator&) = delete;
+
+  memory_allocator& operator=(memory_allocator&&) = delete;
+
+  virtual ~memory_allocator() = default;
+
+  /// @brief Allocates memory.
+  ///
+  /// @param size The number of bytes to allocate. This is never zero.
+  ///
+  /// @param alignment The alignment of the memory, which is a power of two no larger than @ref texel_alignment.
+  ///
+  /// @return A pointer to the memory, or a null pointer if it could not be allocated.
+  virtual void* allocate(size_t size, size_t alignment) = 0;
+
+  /// @brief Changes the size of an allocation, keeping its contents up to the smaller of the two sizes.
+  ///
+  /// @param data The memory to resize, which may be null if the old size is zero.
+  ///
+  /// @param old_size The number of bytes that were allocated.
+  ///
+  /// @param new_size The number of bytes to allocate. If this is zero, the memory is freed.
+  ///
+  /// @param alignment The alignment that the memory was allocated with.
+  ///
+  /// @return A pointer to the resized memory, or a null pointer if it could not be allocated (in which case the
+  ///         original memory is left as it was) or the new size is zero.
+  virtual void* reallocate(void* data, size_t old_size, size_t new_size, size_t alignment) = 0;
+
+  /// @brief Frees memory allocated by @ref memory_allocator::allocate or @ref memory_allocator::reallocate.
+  ///
+  /// @param data The memory to free. This may be null.
+  ///
+  /// @param size The number of bytes that were allocated.
+  virtual void deallocate(void* data, size_t size) = 0;
+};
+
+/// @brief Gets the allocator that devices use when the host does not give one.
+///        It allocates with @ref allocate_texel_storage.
+///
+/// @return The default allocator.
+const std::shared_ptr<memory_allocator>&
+get_default_allocator();
+
+/// @brief A standard allocator that allocates through a @ref memory_allocator, aligned to @ref texel_alignment.
+template<typename T>
+class texel_allocator
+{
+public:
+  using value_type = T;
+
+  /// @brief Constructs an allocator that uses the default allocator.
+  texel_allocator()
+    : allocator_(get_default_allocator())
+  {
+  }
+
+  /// @brief Constructs an allocator that uses a given allocator.
+  ///        The allocator is kept alive by every container that uses it.
+  explicit texel_allocator(std::shared_ptr<memory_allocator> allocator) noexcept
+    : allocator_(std::move(allocator))
+  {
+  }
+
+  /// @brief Copies an allocator. This is also used for moves, since a moved-from allocator must stay usable.
+  texel_allocator(const texel_allocator&) noexcept = default;
+
+  template<typename Other>
+  texel_allocator(const texel_allocator<Other>& other) noexcept
+    : allocator_(other.get_allocator())
+  {
+  }
+
+  T* allocate(const size_t count)
+  {
+    if (count == 0)
+      return nullptr;
+
+    auto* data = allocator_->allocate(count * sizeof(T), texel_alignment);
+
+    if (!data)
+      throw std::bad_alloc();
+
+    return static_cast<T*>(data);
+  }
+
+  void deallocate(T* data, const size_t count) noexcept
+  {
+    if (data)
+      allocator_->deallocate(data, count * sizeof(T));
+  }
+
+  /// @brief Default-initializes an element, which leaves trivial types unwritten.
+  ///        This lets the owner of the storage choose which thread first writes to each page.
+  template<typename U>
+  void construct(U* ptr) noexcept(std::is_nothrow_default_constructible<U>::value)
+  {
+    ::new (static_cast<void*>(ptr)) U;
+  }
+
+  template<typename U, typename... Args>
+  void construct(U* ptr, Args&&... args)
+  {
+    ::new (static_cast<void*>(ptr)) U(std::forward<Args>(args)...);
+  }
+
+  template<typename Other>
+  bool operator==(const texel_allocator<Other>& other) const noexcept
+  {
+    return allocator_ == other.get_allocator();
+  }
+
+  template<typename Other>
+  bool operator!=(const texel_allocator<Other>& other) const noexcept
+  {
+    return allocator_ != other.get_allocator();
+  }
+
+  [[nodiscard]] const std::shared_ptr<memory_allocator>& get_allocator() const noexcept { return allocator_; }
+
+private:
+  std::shared_ptr<memory_allocator> allocator_;
+};
+
+/// @brief A vector of texels, allocated for texel storage.
+using texel_vector = std::vector<glm::vec4, texel_allocator<glm::vec4>>;
+
+} // namespace ptg
@@ -1,7 +1,140 @@
 #pragma once
 
+#include "scratch_arena.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+#include <stddef.h>
+#include <stdint.h>
+
 namespace ptg {
 
+class page_cache;
+
+/// @brief Used to select where and how the texel data of a texture is stored.
+enum class texture_storage
+{
+  /// @brief The texels are stored in memory, in row-major order.
+  memory,
+  /// @brief The texels are stored in a file, in tiles, and only a bounded number of tiles are kept in memory.
+  paged,
+  /// @brief The texels are stored in tiles that are only allocated once written to.
+  sparse,
+  /// @brief The texels are stored in a memory-mapped file, in row-major order.
+  mapped,
+  /// @brief The texels are stored in memory, in blocks compressed as a base value plus packed deltas.
+  compressed
+};
+
+/// @brief Used to select the order that texels are arranged in memory.
+enum class texture_layout
+{
+  /// @brief Texels are stored one row after another.
+  linear,
+  /// @brief Texels are stored in square blocks, one block after another.
+  ///        This keeps texels that are close in both axes close in memory, which suits 2D access patterns.
+  tiled
+};
+
+/// @brief Used to select the format that each texel is stored in.
+enum class texel_format
+{
+  /// @brief Four 32-bit floats.
+  rgba32f,
+  /// @brief Four 16-bit (half precision) floats.
+  rgba16f,
+  /// @brief Four 16-bit unsigned integers, mapped linearly onto a range of values given by a scale and offset.
+  rgba16_unorm
+};
+
+/// @brief Options for textures stored in memory-mapped files.
+enum map_flags : uint32_t
+{
+  /// @brief Fault in every page of the file when it is mapped, instead of on first access.
+  map_flag_populate = 1,
+  /// @brief Ask for the mapping to be backed by huge pages, where the file system supports it.
+  map_flag_huge_pages = 2
+};
+
+/// @brief Describes a texture to be created.
+struct texture_desc final
+{
+  /// @brief The size of the texture, in both axes.
+  uint32_t size{ 0 };
+
+  /// @brief Where the texel data is stored.
+  texture_storage storage{ texture_storage::memory };
+
+  /// @brief For textures stored in memory, the order that texels are arranged in.
+  ///        This only applies to 32-bit float textures.
+  texture_layout layout{ texture_layout::linear };
+
+  /// @brief For textures stored in memory, the format that each texel is stored in.
+  texel_format format{ texel_format::rgba32f };
+
+  /// @brief For unsigned normalized formats, the width of the range of values that can be stored.
+  float format_scale{ 1.0f };
+
+  /// @brief For unsigned normalized formats, the smallest value that can be stored.
+  float format_offset{ 0.0f };
+
+  /// @brief For paged textures, the cache that tiles are loaded into.
+  ///        Textures sharing a cache also share its memory budget.
+  ///        If this is null, the texture gets a cache of its own.
+  std::shared_ptr<page_cache> cache;
+
+  /// @brief For mapped textures, the path of the file to store the texels in.
+  std::string path;
+
+  /// @brief For mapped textures, a combination of @ref map_flags.
+  uint32_t map_flags{ 0 };
+
+  /// @brief For compressed textures, the largest difference allowed between a written value and the value read back.
+  ///        A value of zero makes the compression lossless.
+  float max_error{ 0.0f };
+};
+
+/// @brief Used to indicate how a mapped tile is going to be accessed.
+enum class tile_access
+{
+  /// @brief The texels are only read.
+  read_only,
+  /// @brief Every texel is overwritten without being read, so the existing contents do not need to be loaded.
+  write_only,
+  /// @brief The texels are both read and written.
+  read_write
+};
+
+/// @brief A rectangle of texels that has been mapped into CPU memory.
+struct texel_tile final
+{
+  /// @brief A pointer to the first texel of the rectangle, or null if the rectangle could not be mapped.
+  glm::vec4* data{ nullptr };
+
+  /// @brief The position of the first texel within the texture.
+  glm::uvec2 origin{ 0, 0 };
+
+  /// @brief The number of texels in each axis of the rectangle.
+  glm::uvec2 size{ 0, 0 };
+
+  /// @brief The number of texels between the start of each row.
+  uint32_t pitch{ 0 };
+
+  /// @brief Accesses a texel in the rectangle.
+  ///
+  /// @param texel The position of the texel, relative to the texture (not the rectangle).
+  ///
+  /// @return A reference to the texel.
+  [[nodiscard]] glm::vec4& at(const glm::uvec2 texel) const
+  {
+    return data[((texel.y - origin.y) * pitch) + (texel.x - origin.x)];
+  }
+};
+
 /// @brief The interface for a texture.
 class texture
 {
@@ -28,6 +161,89 @@ public:
   /// @return The size of the texture, in both axes.
   virtual uint32_t get_size() const = 0;
 
+  /// @brief Gets the description of the texture, which can be used to create textures of the same kind.
+  ///
+  /// @return The description of the texture.
+  [[nodiscard]] virtual texture_desc get_desc() const = 0;
+
+  /// @brief Gets the number of bytes of memory that the texture currently holds.
+  ///        Storage shared with copies of the texture is divided evenly between them. This may be called while other
+  ///        threads map regions of the texture.
+  ///
+  /// @return The number of bytes of memory held by the texture.
+  [[nodiscard]] virtual size_t get_memory_usage() const = 0;
+
+  /// @brief Gets the size of the tiles that the texture is stored as.
+  ///        Regions that are mapped must not cross the border of a tile.
+  ///
+  /// @return The size of a tile, in both axes.
+  [[nodiscard]] virtual uint32_t get_tile_size() const = 0;
+
+  /// @brief Maps a rectangle of texels into CPU memory.
+  ///        Different threads may map different rectangles of the same texture at the same time.
+  ///
+  /// @details Textures that convert their texels when mapped decode them into the scratch arena of the calling
+  ///          thread (see @ref scratch_arena::get_thread_arena). That memory is only reclaimed when the enclosing
+  ///          @ref scratch_arena::scope ends, so callers that map regions in a loop should open a scope for each
+  ///          iteration. Kernel dispatches already do so for each tile.
+  ///
+  /// @param origin The position of the first texel to map.
+  ///
+  /// @param size The number of texels to map in each axis. The rectangle must lie within a single tile.
+  ///
+  /// @param access How the texels are going to be accessed.
+  ///
+  /// @return The mapped texels. They remain valid until passed to @ref texture::unmap_region.
+  ///         If the texels could not be mapped (because they could not be read or allocated), the data pointer is
+  ///         null. The failure has already been reported to the device, and the caller should skip the rectangle.
+  virtual texel_tile map_region(glm::uvec2 origin, glm::uvec2 size, tile_access access) = 0;
+
+  /// @brief Releases a rectangle of texels mapped by @ref texture::map_region.
+  ///
+  /// @param tile The mapped rectangle. Rectangles that failed to map may be passed, and are ignored.
+  ///
+  /// @param access The access that the rectangle was mapped with.
+  virtual void unmap_region(const texel_tile& tile, tile_access access) = 0;
+
+  /// @brief Checks whether a rectangle of texels is known to contain a single value, without reading the texels.
+  ///        Kernels use this to skip work on regions of a texture that have never been written to.
+  ///
+  /// @param origin The position of the first texel of the rectangle.
+  ///
+  /// @param size The number of texels in each axis of the rectangle. The rectangle must lie within a single tile.
+  ///
+  /// @param value Assigned the value of the texels, if they are known to be constant.
+  ///
+  /// @return True if every texel in the rectangle is known to equal the value, false otherwise.
+  virtual bool is_constant(glm::uvec2 origin, glm::uvec2 size, glm::vec4* value)
+  {
+    (void)origin;
+    (void)size;
+    (void)value;
+    return false;
+  }
+
+  /// @brief Assigns every texel in a rectangle the same value.
+  ///
+  /// @param origin The position of the first texel of the rectangle.
+  ///
+  /// @param size The number of texels in each axis of the rectangle. The rectangle must lie within a single tile.
+  ///
+  /// @param value The value to assign the texels.
+  virtual void fill_region(const glm::uvec2 origin, const glm::uvec2 size, const glm::vec4& value)
+  {
+    const scratch_arena::scope scratch_scope(scratch_arena::get_thread_arena());
+
+    const auto tile = map_region(origin, size, tile_access::write_only);
+    if (!tile.data)
+      return;
+
+    for (uint32_t y = 0; y < size.y; y++)
+      std::fill_n(&tile.data[y * tile.pitch], size.x, value);
+
+    unmap_region(tile, tile_access::write_only);
+  }
+
   /// @brief If possible, returns a pointer to the texture data.
   ///
   /// @return A pointer to the texture data.
@@ -0,0 +1,293 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace ptg {
+
+namespace {
+
+/// @brief The NUMA node of the calling thread, if it is a pinned worker.
+thread_local int32_t worker_node = -1;
+
+/// @brief Parses a CPU list in the format used by sysfs, such as "0-3,8-11".
+std::vector<uint32_t>
+parse_cpu_list(const std::string& list)
+{
+  std::vector<uint32_t> cpus;
+
+  std::istringstream stream(list);
+
+  std::string range;
+
+  while (std::getline(stream, range, ',')) {
+
+    const auto dash = range.find('-');
+
+    try {
+      const auto first = static_cast<uint32_t>(std::stoul(range.substr(0, dash)));
+      const auto last = (dash == std::string::npos) ? first : static_cast<uint32_t>(std::stoul(range.substr(dash + 1)));
+      for (auto cpu = first; cpu <= last; cpu++)
+        cpus.emplace_back(cpu);
+    } catch (const std::exception&) {
+      // Ignore ranges that cannot be parsed, such as trailing whitespace.
+    }
+  }
+
+  return cpus;
+}
+
+/// @brief Finds the CPUs of each NUMA node that the process is allowed to run on.
+///        Nodes without such CPUs are left out. On systems without NUMA information, this returns no nodes.
+std::vector<std::vector<uint32_t>>
+find_node_cpus()
+{
+  std::vector<std::vector<uint32_t>> nodes;
+
+#ifdef __linux__
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+    return nodes;
+
+  for (uint32_t node = 0;; node++) {
+
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    if (!file.good())
+      break;
+
+    std::string list;
+    std::getline(file, list);
+
+    auto cpus = parse_cpu_list(list);
+
+    auto is_disallowed = [&allowed](const uint32_t cpu) { return (cpu >= CPU_SETSIZE) || !CPU_ISSET(cpu, &allowed); };
+
+    cpus.erase(std::remove_if(cpus.begin(), cpus.end(), is_disallowed), cpus.end());
+
+    if (!cpus.empty())
+      nodes.emplace_back(std::move(cpus));
+  }
+#endif
+
+  return nodes;
+}
+
+void
+pin_thread(std::thread& t, const std::vector<uint32_t>& cpus)
+{
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+
+  for (const auto cpu : cpus)
+    CPU_SET(cpu, &set);
+
+  // Failure leaves the thread free to run anywhere, which is still correct.
+  pthread_setaffinity_np(t.native_handle(), sizeof(set), &set);
+#else
+  (void)t;
+  (void)cpus;
+#endif
+}
+
+} // namespace
+
+thread_pool::thread_pool(uint32_t thread_count)
+  : node_cpus_(find_node_cpus())
+{
+  if (thread_count == 0)
+    thread_count = std::thread::hardware_concurrency();
+
+  const bool numa = node_cpus_.size() > 1;
+
+  if (!numa)
+    node_cpus_.assign(1, std::vector<uint32_t>());
+
+  const auto node_count = static_cast<uint32_t>(node_cpus_.size());
+
+  // The calling thread always participates in parallel work, so one less worker is needed.
+  // Workers are assigned to nodes in contiguous groups, counting the calling thread as the first.
+  for (uint32_t i = 1; i < thread_count; i++) {
+
+    const auto node = static_cast<uint32_t>((static_cast<uint64_t>(i) * node_count) / thread_count);
+
+    workers_.emplace_back(&thread_pool::run_worker, this, node);
+
+    if (numa)
+      pin_thread(workers_.back(), node_cpus_[node]);
+  }
+}
+
+thread_pool::~thread_pool()
+{
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+
+    should_exit_ = true;
+  }
+
+  task_condition_.notify_all();
+
+  for (auto& w : workers_)
+    w.join();
+}
+
+void
+thread_pool::parallel_for(const uint32_t count, const std::function<void(uint32_t index)>& func)
+{
+  if ((count <= 1) || workers_.empty()) {
+    for (uint32_t i = 0; i < count; i++)
+      func(i);
+    return;
+  }
+
+  // The job state outlives this call, since helper tasks may still be queued after all indices are processed.
+  struct job final
+  {
+    /// @brief The indices assigned to a NUMA node.
+    struct node_range final
+    {
+      std::atomic<uint32_t> next_index{ 0 };
+
+      uint32_t end{ 0 };
+    };
+
+    const std::function<void(uint32_t)>* func{ nullptr };
+
+    uint32_t count{ 0 };
+
+    uint32_t node_count{ 0 };
+
+    std::unique_ptr<node_range[]> ranges;
+
+    std::atomic<uint32_t> completed{ 0 };
+
+    std::mutex lock;
+
+    std::condition_variable done;
+  };
+
+  const auto node_count = get_node_count();
+
+  auto j = std::make_shared<job>();
+  j->func = &func;
+  j->count = count;
+  j->node_count = node_count;
+  j->ranges.reset(new job::node_range[node_count]);
+
+  for (uint32_t n = 0; n < node_count; n++) {
+    j->ranges[n].next_index = static_cast<uint32_t>((static_cast<uint64_t>(n) * count) / node_count);
+    j->ranges[n].end = static_cast<uint32_t>((static_cast<uint64_t>(n + 1) * count) / node_count);
+  }
+
+  auto work = [](job& state, const uint32_t home_node) {
+    for (uint32_t n = 0; n < state.node_count; n++) {
+
+      auto& range = state.ranges[(home_node + n) % state.node_count];
+
+      for (;;) {
+
+        const auto index = range.next_index.fetch_add(1);
+        if (index >= range.end)
+          break;
+
+        (*state.func)(index);
+
+        if ((state.completed.fetch_add(1) + 1) == state.count) {
+          std::lock_guard<std::mutex> guard(state.lock);
+          state.done.notify_all();
+        }
+      }
+    }
+  };
+
+  const auto helper_count = std::min(static_cast<uint32_t>(workers_.size()), count - 1);
+
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+
+    for (uint32_t i = 0; i < helper_count; i++)
+      tasks_.emplace_back([j, work]() { work(*j, static_cast<uint32_t>(worker_node)); });
+  }
+
+  task_condition_.notify_all();
+
+  work(*j, get_current_node());
+
+  std::unique_lock<std::mutex> guard(j->lock);
+
+  j->done.wait(guard, [&j]() { return j->completed.load() == j->count; });
+}
+
+void
+thread_pool::submit(std::function<void()> task)
+{
+  if (workers_.empty()) {
+    task();
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+
+    tasks_.emplace_back(std::move(task));
+  }
+
+  task_condition_.notify_one();
+}
+
+uint32_t
+thread_pool::get_current_node() const
+{
+  if (worker_node >= 0)
+    return static_cast<uint32_t>(worker_node);
+
+#ifdef __linux__
+  const auto cpu = sched_getcpu();
+
+  for (uint32_t n = 0; n < node_cpus_.size(); n++) {
+    if (std::find(node_cpus_[n].begin(), node_cpus_[n].end(), static_cast<uint32_t>(cpu)) != node_cpus_[n].end())
+      return n;
+  }
+#endif
+
+  return 0;
+}
+
+void
+thread_pool::run_worker(const uint32_t node)
+{
+  worker_node = static_cast<int32_t>(node);
+
+  for (;;) {
+
+    std::function<void()> task;
+
+    {
+      std::unique_lock<std::mutex> guard(lock_);
+
+      task_condition_.wait(guard, [this]() { return should_exit_ || !tasks_.empty(); });
+
+      if (tasks_.empty())
+        return;
+
+      task = std::move(tasks_.front());
+
+      tasks_.pop_front();
+    }
+
+    task();
+  }
+}
+
+} // namespace ptg
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "scheduler.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <stdint.h>
+
+namespace ptg {
+
+/// @brief A fixed set of worker threads owned by a device.
+///        Used for spreading kernel dispatches and other device work across cores.
+///
+/// @details On machines with more than one NUMA node, the workers are spread across the nodes and pinned to the
+///          CPUs of the node they are assigned. Parallel loops then hand each node a contiguous share of the
+///          indices, so that work on the same index always tends to run on the same node. Memory that is first
+///          written by such a loop is placed on the node that later processes it.
+class thread_pool final : public scheduler
+{
+public:
+  /// @brief Constructs a new thread pool.
+  ///
+  /// @param thread_count The number of worker threads to start.
+  ///                     If this is zero, the number of hardware threads is used instead.
+  explicit thread_pool(uint32_t thread_count = 0);
+
+  thread_pool(const thread_pool&) = delete;
+
+  thread_pool(thread_pool&&) = delete;
+
+  thread_pool& operator=(const thread_pool&) = delete;
+
+  thread_pool& operator=(thread_pool&&) = delete;
+
+  ~thread_pool() override;
+
+  /// @brief Gets the number of worker threads in the pool.
+  ///
+  /// @return The number of worker threads in the pool.
+  [[nodiscard]] uint32_t get_thread_count() const { return static_cast<uint32_t>(workers_.size()); }
+
+  /// @brief Gets the number of NUMA nodes that the workers are spread across.
+  ///
+  /// @return The number of NUMA nodes, which is one on machines without NUMA.
+  [[nodiscard]] uint32_t get_node_count() const { return static_cast<uint32_t>(node_cpus_.size()); }
+
+  /// @brief Calls a function once for each index in [0, count), spreading the calls across the workers.
+  ///        The calling thread participates and this function returns once every index has been processed.
+  ///        It is safe to call this function from within a worker thread.
+  ///
+  ///        The indices are split into one contiguous range per NUMA node, in node order. Threads take indices from
+  ///        the range of their own node first and from the ranges of other nodes once it runs out.
+  ///
+  /// @param count The number of indices to process.
+  ///
+  /// @param func The function to call for each index.
+  void parallel_for(uint32_t count, const std::function<void(uint32_t index)>& func) override;
+
+  /// @brief Queues a task to be run asynchronously by one of the workers.
+  ///        If there are no workers, the task is run immediately on the calling thread.
+  ///
+  /// @param task The task to run.
+  void submit(std::function<void()> task);
+
+private:
+  void run_worker(uint32_t node);
+
+  /// @brief Gets the NUMA node that the calling thread runs on.
+  [[nodiscard]] uint32_t get_current_node() const;
+
+  /// @brief The CPUs of each NUMA node that this process may run on.
+  std::vector<std::vector<uint32_t>> node_cpus_;
+
+  std::vector<std::thread> workers_;
+
+  std::deque<std::function<void()>> tasks_;
+
+  std::mutex lock_;
+
+  std::condition_variable task_condition_;
+
+  bool should_exit_{ false };
+};
+
+} // namespace ptg
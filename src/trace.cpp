@@ -0,0 +1,121 @@
+#include "trace.hpp"
+
+#include <fstream>
+#include <string>
+
+namespace ptg {
+
+trace_recorder::trace_recorder()
+  : epoch_(std::chrono::steady_clock::now())
+{
+}
+
+trace_recorder::~trace_recorder() = default;
+
+void
+trace_recorder::enable(const size_t capacity)
+{
+  enabled_ = false;
+
+  events_.reset(capacity ? new event[capacity] : nullptr);
+
+  capacity_ = capacity;
+
+  next_index_ = 0;
+
+  enabled_ = capacity > 0;
+}
+
+uint64_t
+trace_recorder::now() const
+{
+  const auto elapsed = std::chrono::steady_clock::now() - epoch_;
+
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+void
+trace_recorder::record(const char* name, const char* category, const uint64_t start, const uint64_t end)
+{
+  if (!is_enabled())
+    return;
+
+  const auto index = next_index_.fetch_add(1, std::memory_order_relaxed);
+
+  auto& e = events_[index % capacity_];
+
+  e.sequence.store(0, std::memory_order_relaxed);
+
+  std::atomic_thread_fence(std::memory_order_release);
+
+  e.name.store(name, std::memory_order_relaxed);
+  e.category.store(category, std::memory_order_relaxed);
+  e.thread_id.store(get_thread_id(), std::memory_order_relaxed);
+  e.start.store(start, std::memory_order_relaxed);
+  e.duration.store(end - start, std::memory_order_relaxed);
+
+  e.sequence.store(index + 1, std::memory_order_release);
+}
+
+bool
+trace_recorder::write(const char* path) const
+{
+  std::ofstream file(path);
+  if (!file.good())
+    return false;
+
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+  // Once the buffer has wrapped around, the oldest event is the one after the most recent.
+  const auto end_index = next_index_.load(std::memory_order_acquire);
+
+  const auto begin_index = (end_index > capacity_) ? (end_index - capacity_) : 0;
+
+  bool first = true;
+
+  for (auto index = begin_index; index < end_index; index++) {
+
+    const auto& e = events_[index % capacity_];
+
+    const auto sequence = e.sequence.load(std::memory_order_acquire);
+
+    // Skip events that are still being written, or that have been replaced by newer events.
+    if (sequence != (index + 1))
+      continue;
+
+    const auto* name = e.name.load(std::memory_order_relaxed);
+    const auto* category = e.category.load(std::memory_order_relaxed);
+    const auto thread_id = e.thread_id.load(std::memory_order_relaxed);
+    const auto start = e.start.load(std::memory_order_relaxed);
+    const auto duration = e.duration.load(std::memory_order_relaxed);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    if (e.sequence.load(std::memory_order_relaxed) != sequence)
+      continue;
+
+    // Times are written in microseconds, which is the unit of the trace format.
+    file << (first ? "\n" : ",\n");
+    file << "{\"name\":\"" << name << "\",\"cat\":\"" << category << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread_id
+         << ",\"ts\":" << std::to_string(static_cast<double>(start) * 1e-3)
+         << ",\"dur\":" << std::to_string(static_cast<double>(duration) * 1e-3) << "}";
+
+    first = false;
+  }
+
+  file << "\n]}\n";
+
+  return file.good();
+}
+
+uint32_t
+trace_recorder::get_thread_id()
+{
+  static std::atomic<uint32_t> next_thread_id{ 1 };
+
+  thread_local const uint32_t thread_id = next_thread_id.fetch_add(1);
+
+  return thread_id;
+}
+
+} // namespace ptg
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace ptg {
+
+/// @brief Records timed events into a ring buffer, to be written out as a Chrome trace.
+///
+/// @details Events can be recorded from any thread without locking. Once the buffer is full, new events replace the
+///          oldest ones. Recording is disabled until a buffer is allocated with @ref trace_recorder::enable. While
+///          disabled, recording an event only checks a flag, and no clocks are read.
+class trace_recorder final
+{
+public:
+  trace_recorder();
+
+  trace_recorder(const trace_recorder&) = delete;
+
+  trace_recorder(trace_recorder&&) = delete;
+
+  trace_recorder& operator=(const trace_recorder&) = delete;
+
+  trace_recorder& operator=(trace_recorder&&) = delete;
+
+  ~trace_recorder();
+
+  /// @brief Starts recording events into a new buffer, discarding any events recorded so far.
+  ///        This must not be called while other threads may be recording events.
+  ///
+  /// @param capacity The number of events to keep. If this is zero, recording is disabled and the buffer is released.
+  void enable(size_t capacity);
+
+  [[nodiscard]] bool is_enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  /// @brief Gets the current time of the trace clock.
+  ///
+  /// @return The number of nanoseconds since the recorder was created.
+  [[nodiscard]] uint64_t now() const;
+
+  /// @brief Records an event that has already finished.
+  ///
+  /// @param name The name of the event. This must be a string literal, or otherwise outlive the recorder.
+  ///
+  /// @param category The category of the event. This must be a string literal, or otherwise outlive the recorder.
+  ///
+  /// @param start The time that the event started, from @ref trace_recorder::now.
+  ///
+  /// @param end The time that the event ended, from @ref trace_recorder::now.
+  void record(const char* name, const char* category, uint64_t start, uint64_t end);
+
+  /// @brief Writes the recorded events to a file, in the Chrome trace event format.
+  ///        The file can be opened with chrome://tracing or Perfetto.
+  ///
+  /// @param path The path of the file to write.
+  ///
+  /// @return True on success, false if the file could not be written.
+  bool write(const char* path) const;
+
+private:
+  /// @brief A single event in the ring buffer.
+  ///
+  /// @details The sequence number is zero while the event is being written, and otherwise one more than the index
+  ///          that the event was recorded at. Readers compare it before and after copying the event, and skip events
+  ///          that were changed in the meantime.
+  struct event final
+  {
+    std::atomic<uint64_t> sequence{ 0 };
+
+    std::atomic<const char*> name{ nullptr };
+
+    std::atomic<const char*> category{ nullptr };
+
+    std::atomic<uint32_t> thread_id{ 0 };
+
+    std::atomic<uint64_t> start{ 0 };
+
+    std::atomic<uint64_t> duration{ 0 };
+  };
+
+  /// @brief Gets a small number that identifies the calling thread in the trace.
+  static uint32_t get_thread_id();
+
+  std::chrono::steady_clock::time_point epoch_;
+
+  std::atomic<bool> enabled_{ false };
+
+  std::unique_ptr<event[]> events_;
+
+  size_t capacity_{ 0 };
+
+  /// @brief The index that the next event is recorded at. Only the remainder modulo the capacity is used.
+  std::atomic<uint64_t> next_index_{ 0 };
+};
+
+/// @brief Records an event that lasts for the lifetime of the scope.
+class trace_scope final
+{
+public:
+  /// @brief Starts an event.
+  ///
+  /// @param recorder The recorder to record the event with. This may be null, in which case nothing is recorded.
+  ///
+  /// @param name The name of the event. This must be a string literal.
+  ///
+  /// @param category The category of the event. This must be a string literal.
+  trace_scope(trace_recorder* recorder, const char* name, const char* category)
+    : recorder_((recorder && recorder->is_enabled()) ? recorder : nullptr)
+      , name_(name)
+      , category_(category)
+      , start_(recorder_ ? recorder_->now() : 0)
+  {
+  }
+
+  trace_scope(const trace_scope&) = delete;
+
+  trace_scope(trace_scope&&) = delete;
+
+  trace_scope& operator=(const trace_scope&) = delete;
+
+  trace_scope& operator=(trace_scope&&) = delete;
+
+  ~trace_scope()
+  {
+    if (recorder_)
+      recorder_->record(name_, category_, start_, recorder_->now());
+  }
+
+private:
+  trace_recorder* recorder_{ nullptr };
+
+  const char* name_{ nullptr };
+
+  const char* category_{ nullptr };
+
+  uint64_t start_{ 0 };
+};
+
+} // namespace ptg